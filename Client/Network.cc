@@ -9,7 +9,7 @@
 using namespace Game;
 
 void Game::on_message(uint8_t *ptr, uint32_t len) {
-    Reader reader(ptr);
+    Reader reader(ptr, ptr + len);
     switch(reader.read<uint8_t>()) {
         case Clientbound::kClientUpdate: {
             simulation_ready = 1;
@@ -53,7 +53,7 @@ void Game::on_message(uint8_t *ptr, uint32_t len) {
 }
 
 void Game::send_inputs() {
-    Writer writer(static_cast<uint8_t *>(OUTGOING_PACKET));
+    Writer writer(OUTGOING_PACKET);
     writer.write<uint8_t>(Serverbound::kClientInput);
     if (Input::freeze_input) {
         writer.write<float>(0);
@@ -68,7 +68,7 @@ void Game::send_inputs() {
 }
 
 void Game::spawn_in() {
-    Writer writer(static_cast<uint8_t *>(OUTGOING_PACKET));
+    Writer writer(OUTGOING_PACKET);
     if (Game::alive()) return;
     if (Game::on_game_screen == 0) {
         writer.write<uint8_t>(Serverbound::kClientSpawn);
@@ -81,7 +81,7 @@ void Game::spawn_in() {
 }
 
 void Game::delete_petal(uint8_t pos) {
-    Writer writer(static_cast<uint8_t *>(OUTGOING_PACKET));
+    Writer writer(OUTGOING_PACKET);
     if (!Game::alive()) return;
     writer.write<uint8_t>(Serverbound::kPetalDelete);
     writer.write<uint8_t>(pos);
@@ -89,7 +89,7 @@ void Game::delete_petal(uint8_t pos) {
 }
 
 void Game::swap_petals(uint8_t pos1, uint8_t pos2) {
-    Writer writer(static_cast<uint8_t *>(OUTGOING_PACKET));
+    Writer writer(OUTGOING_PACKET);
     if (!Game::alive()) return;
     writer.write<uint8_t>(Serverbound::kPetalSwap);
     writer.write<uint8_t>(pos1);
@@ -104,8 +104,7 @@ void Game::swap_all_petals() {
 }
 
 void Game::send_chat(std::string const& text) {
-    uint8_t packet[100];
-    Writer writer(static_cast<uint8_t*>(packet));
+    Writer writer(OUTGOING_PACKET);
     if (!Game::alive()) return;
     writer.write<uint8_t>(Serverbound::kChatSend);
     writer.write<std::string>(text);
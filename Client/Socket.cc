@@ -9,14 +9,20 @@
 
 #include <emscripten.h>
 
-uint8_t INCOMING_PACKET[64 * 1024] = {0};
-uint8_t OUTGOING_PACKET[1 * 1024] = {0};
+std::vector<uint8_t> INCOMING_PACKET(64 * 1024);
+std::vector<uint8_t> OUTGOING_PACKET;
 
 extern "C" {
+    //where the next <len> byte packet gets copied to
+    uint8_t *incoming_buffer(uint32_t len) {
+        if (INCOMING_PACKET.size() < len) INCOMING_PACKET.resize(len);
+        return INCOMING_PACKET.data();
+    }
+
     void on_message(uint8_t type, uint32_t len, char *reason) {
         if (type == 0) {
             std::printf("Connected\n");
-            Writer w(INCOMING_PACKET);
+            Writer w(OUTGOING_PACKET);
             w.write<uint8_t>(Serverbound::kVerify);
             w.write<uint64_t>(VERSION_HASH);
             Game::reset();
@@ -36,7 +42,7 @@ extern "C" {
         }
         else if (type == 1) {
             Game::socket.ready = 1;
-            Game::on_message(INCOMING_PACKET, len);
+            Game::on_message(INCOMING_PACKET.data(), len);
         }
     }
 }
@@ -46,7 +52,7 @@ Socket::Socket() {}
 void Socket::connect(std::string const url) {
     std::cout << "Connecting to " << url << '\n';
     EM_ASM({
-        let string = UTF8ToString($1);
+        let string = UTF8ToString($0);
         function connect() {
             let socket = Module.socket = new WebSocket(string);
             socket.binaryType = "arraybuffer";
@@ -58,12 +64,15 @@ void Socket::connect(std::string const url) {
                 setTimeout(connect, 1000);
             };
             socket.onmessage = function(event) {
-                HEAPU8.set(new Uint8Array(event.data), $0);
-                _on_message(1, event.data.byteLength, 0);
+                let data = new Uint8Array(event.data);
+                //growing the buffer can replace HEAPU8, so look it up after
+                let ptr = _incoming_buffer(data.length);
+                HEAPU8.set(data, ptr);
+                _on_message(1, data.length, 0);
             };
         }
         setTimeout(connect, 1000);
-    }, INCOMING_PACKET, url.c_str());
+    }, url.c_str());
 }
 
 void Socket::send(uint8_t *ptr, uint32_t len) {
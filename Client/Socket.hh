@@ -2,9 +2,11 @@
 
 #include <cstdint>
 #include <string>
+#include <vector>
 
-extern uint8_t INCOMING_PACKET[64 * 1024];
-extern uint8_t OUTGOING_PACKET[1 * 1024];
+//grows to fit the largest packet received so far
+extern std::vector<uint8_t> INCOMING_PACKET;
+extern std::vector<uint8_t> OUTGOING_PACKET;
 
 class Socket {
 public:
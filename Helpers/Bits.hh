@@ -12,14 +12,17 @@ namespace BitMath {
     template<typename T>
     constexpr void unset(T &val, uint32_t bit) { val &= ~((T) 1 << bit); };
 
-    constexpr uint8_t at_arr(uint8_t const *arr, uint32_t bit) { 
-        return at(arr[bit >> 3], bit & 7);
+    template<typename T>
+    constexpr uint8_t at_arr(T const *arr, uint32_t bit) { 
+        return at(arr[bit / (8 * sizeof(T))], bit % (8 * sizeof(T)));
     };
-    constexpr void set_arr(uint8_t *arr, uint32_t bit) {
-        set(arr[bit >> 3], bit & 7);
+    template<typename T>
+    constexpr void set_arr(T *arr, uint32_t bit) {
+        set(arr[bit / (8 * sizeof(T))], bit % (8 * sizeof(T)));
     };
-    constexpr void unset_arr(uint8_t *arr, uint32_t bit) {
-        unset(arr[bit >> 3], bit & 7);
+    template<typename T>
+    constexpr void unset_arr(T *arr, uint32_t bit) {
+        unset(arr[bit / (8 * sizeof(T))], bit % (8 * sizeof(T)));
     };
 }
 
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <Helpers/Math.hh>
+
+#include <cstdint>
+
+//float lanes for the batched server passes, LANES floats per op. every
+//op is the plain float op, no fused multiply-add, so a pass that keeps the
+//scalar op order gets bit-identical results on every target
+#if defined(__AVX__)
+#include <immintrin.h>
+typedef __m256 lane_t;
+static uint32_t const LANES = 8;
+static inline lane_t _load(float const *p) { return _mm256_loadu_ps(p); }
+static inline void _store(float *p, lane_t v) { _mm256_storeu_ps(p, v); }
+static inline lane_t _splat(float v) { return _mm256_set1_ps(v); }
+static inline lane_t _add(lane_t a, lane_t b) { return _mm256_add_ps(a, b); }
+static inline lane_t _sub(lane_t a, lane_t b) { return _mm256_sub_ps(a, b); }
+static inline lane_t _mul(lane_t a, lane_t b) { return _mm256_mul_ps(a, b); }
+static inline lane_t _clamp(lane_t v, lane_t s, lane_t e) {
+    lane_t ret = _mm256_blendv_ps(e, v, _mm256_cmp_ps(v, e, _CMP_LE_OQ));
+    return _mm256_blendv_ps(s, ret, _mm256_cmp_ps(v, s, _CMP_GE_OQ));
+}
+//bit i is set if lane i of a <= lane i of b
+static inline uint32_t _le_mask(lane_t a, lane_t b) { return _mm256_movemask_ps(_mm256_cmp_ps(a, b, _CMP_LE_OQ)); }
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+typedef __m128 lane_t;
+static uint32_t const LANES = 4;
+static inline lane_t _load(float const *p) { return _mm_loadu_ps(p); }
+static inline void _store(float *p, lane_t v) { _mm_storeu_ps(p, v); }
+static inline lane_t _splat(float v) { return _mm_set1_ps(v); }
+static inline lane_t _add(lane_t a, lane_t b) { return _mm_add_ps(a, b); }
+static inline lane_t _sub(lane_t a, lane_t b) { return _mm_sub_ps(a, b); }
+static inline lane_t _mul(lane_t a, lane_t b) { return _mm_mul_ps(a, b); }
+static inline lane_t _clamp(lane_t v, lane_t s, lane_t e) {
+    lane_t le = _mm_cmple_ps(v, e);
+    lane_t ret = _mm_or_ps(_mm_and_ps(le, v), _mm_andnot_ps(le, e));
+    lane_t ge = _mm_cmpge_ps(v, s);
+    return _mm_or_ps(_mm_and_ps(ge, ret), _mm_andnot_ps(ge, s));
+}
+static inline uint32_t _le_mask(lane_t a, lane_t b) { return _mm_movemask_ps(_mm_cmple_ps(a, b)); }
+#elif defined(__wasm_simd128__)
+#include <wasm_simd128.h>
+typedef v128_t lane_t;
+static uint32_t const LANES = 4;
+static inline lane_t _load(float const *p) { return wasm_v128_load(p); }
+static inline void _store(float *p, lane_t v) { wasm_v128_store(p, v); }
+static inline lane_t _splat(float v) { return wasm_f32x4_splat(v); }
+static inline lane_t _add(lane_t a, lane_t b) { return wasm_f32x4_add(a, b); }
+static inline lane_t _sub(lane_t a, lane_t b) { return wasm_f32x4_sub(a, b); }
+static inline lane_t _mul(lane_t a, lane_t b) { return wasm_f32x4_mul(a, b); }
+static inline lane_t _clamp(lane_t v, lane_t s, lane_t e) {
+    lane_t ret = wasm_v128_bitselect(v, e, wasm_f32x4_le(v, e));
+    return wasm_v128_bitselect(ret, s, wasm_f32x4_ge(v, s));
+}
+static inline uint32_t _le_mask(lane_t a, lane_t b) { return wasm_i32x4_bitmask(wasm_f32x4_le(a, b)); }
+#else
+typedef float lane_t;
+static uint32_t const LANES = 1;
+static inline lane_t _load(float const *p) { return *p; }
+static inline void _store(float *p, lane_t v) { *p = v; }
+static inline lane_t _splat(float v) { return v; }
+static inline lane_t _add(lane_t a, lane_t b) { return a + b; }
+static inline lane_t _sub(lane_t a, lane_t b) { return a - b; }
+static inline lane_t _mul(lane_t a, lane_t b) { return a * b; }
+static inline lane_t _clamp(lane_t v, lane_t s, lane_t e) { return fclamp(v, s, e); }
+static inline uint32_t _le_mask(lane_t a, lane_t b) { return a <= b; }
+#endif
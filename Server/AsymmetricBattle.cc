@@ -52,19 +52,16 @@ struct AsymmetricBattle::AsymmetricBattleInternal {
                 int lowest_score = INT_MAX;
 
                 // ҷ͵ĺ
-                for (uint16_t i = 0; i < ENTITY_CAP; ++i) {
-                    EntityID id(i, 0);
-                    Entity& ent = sim.get_ent(id);
-                    Entity* cam = sim.ent_alive(ent.get_parent()) ? &sim.get_ent(ent.get_parent()) : nullptr;
-                    if (!ent.has_component(kFlower)) continue;
-                    if (ent.get_color() != ColorID::kRed) continue;
+                sim.for_each_entity([&](Simulation *, Entity &ent) {
+                    if (!ent.has_component(kFlower) || ent.pending_delete) return;
+                    if (ent.get_color() != ColorID::kRed) return;
 
                     int score = ent.get_score();
                     if (score < lowest_score) {
                         lowest_score = score;
                         worst_player = &ent;
                     }
-                }
+                });
 
                 if (worst_player) {
                     Entity& old_camera = sim.get_ent(worst_player->get_parent());
@@ -90,20 +87,16 @@ struct AsymmetricBattle::AsymmetricBattleInternal {
                 int lowest_score = INT_MAX;
 
                 // ҷ͵Ļƶ
-                for (uint16_t i = 0; i < ENTITY_CAP; ++i) {
-                    EntityID id(i, 0);
-                    Entity& ent = sim.get_ent(id);
-                    Entity* cam = sim.ent_alive(ent.get_parent()) ? &sim.get_ent(ent.get_parent()) : nullptr;
-
-                    if (!ent.has_component(kFlower)) continue;
-                    if (ent.get_color() != ColorID::kYellow) continue;
+                sim.for_each_entity([&](Simulation *, Entity &ent) {
+                    if (!ent.has_component(kFlower) || ent.pending_delete) return;
+                    if (ent.get_color() != ColorID::kYellow) return;
 
                     int score = ent.get_score();
                     if (score < lowest_score) {
                         lowest_score = score;
                         worst_player = &ent;
                     }
-                }
+                });
 
                 if (worst_player) {
                     Entity& old_camera = sim.get_ent(worst_player->get_parent());
@@ -139,15 +132,11 @@ struct AsymmetricBattle::AsymmetricBattleInternal {
         {
             bool dummy_exists = false;
             Simulation& sim = game_instance->simulation;
-            for (uint16_t i = 0; i < ENTITY_CAP; ++i) {
-                EntityID id(i, 0);
-                if (!sim.ent_exists(id)) continue;
-                Entity& ent = sim.get_ent(id);
-                if (ent.get_mob_id() == MobID::kTargetDummy) {
+            sim.for_each_entity([&](Simulation *, Entity &ent) {
+                if (!ent.has_component(kMob) || ent.pending_delete) return;
+                if (ent.get_mob_id() == MobID::kTargetDummy)
                     dummy_exists = true;
-                    break;
-                }
-            }
+            });
             if (!dummy_exists) {
                 // yellow ʤ
                 finished = true;
@@ -222,14 +211,12 @@ struct AsymmetricBattle::AsymmetricBattleInternal {
         Simulation& sim = game_instance->simulation;
         if (winner_color < 0) return;
 
-        for (uint16_t i = 0; i < ENTITY_CAP; ++i) {
-            EntityID id(i, 0);
-            Entity& ent = sim.get_ent(id);
-            if (!ent.has_component(kFlower)) continue;
+        sim.for_each_entity([&](Simulation *, Entity &ent) {
+            if (!ent.has_component(kFlower) || ent.pending_delete) return;
             if (static_cast<int>(ent.get_color()) != winner_color) {
                 ent.health = 0; // ֱӸ health killallmobs һ
             }
-        }
+        });
     }
 
     GameInstance* game_instance;
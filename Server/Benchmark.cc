@@ -0,0 +1,133 @@
+#include <Server/Client.hh>
+#include <Server/Game.hh>
+#include <Server/Server.hh>
+#include <Server/Spawn.hh>
+#include <Server/ThreadPool.hh>
+#include <Server/TickProfiler.hh>
+
+#include <Shared/Map.hh>
+#include <Shared/Simulation.hh>
+
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+//headless stand-in for Main.cc + Native.cc
+//usage: gardn-bench [players] [ticks] [seed] [warmup ticks] [extra mobs] [threads]
+//runs Server::game with synthetic players and prints per-phase tick timings
+
+static uint64_t bytes_sent = 0;
+//fingerprint of every update packet after warmup, replication changes that
+//keep the protocol should keep this too. chat and broadcasts are left out,
+//some of them are timed by the wall clock
+static uint64_t packet_hash = 14695981039346656037ull;
+
+void Server::run() {}
+
+void Client::send_packet(std::string_view packet) {
+    bytes_sent += packet.size();
+    if (packet[0] != Clientbound::kClientUpdate) return;
+    for (uint8_t c : packet)
+        packet_hash = (packet_hash ^ c) * 1099511628211ull;
+}
+
+static void _drive_player(Simulation *sim, Client &client) {
+    //turned away by add_client, the world was full
+    if (client.game == nullptr) return;
+    Entity &camera = sim->get_ent(client.camera);
+    if (!sim->ent_exists(camera.get_player())) {
+        Entity &player = alloc_player(sim, camera.get_team());
+        player_spawn(sim, camera, player);
+        player.set_name("bench");
+        return;
+    }
+    Entity &player = sim->get_ent(camera.get_player());
+    if (frand() < 0.05) player.acceleration() = Vector::rand(PLAYER_ACCELERATION);
+    if (frand() < 0.05) player.input = frand() * 4;
+}
+
+static void _print_row(char const *name, std::vector<uint64_t> &v) {
+    uint64_t sum = 0;
+    for (uint64_t x : v) sum += x;
+    std::sort(v.begin(), v.end());
+    std::printf("%-12s %10.1f %10.1f %10.1f %10.1f\n", name,
+        sum / (v.size() * 1000.0),
+        v[(v.size() - 1) / 2] / 1000.0,
+        v[(v.size() - 1) * 99 / 100] / 1000.0,
+        v.back() / 1000.0);
+}
+
+int main(int argc, char **argv) {
+    uint32_t player_count = argc > 1 ? std::stoul(argv[1]) : 40;
+    uint32_t tick_count = argc > 2 ? std::stoul(argv[2]) : 2000;
+    uint32_t seed = argc > 3 ? std::stoul(argv[3]) : 1;
+    uint32_t warmup = argc > 4 ? std::stoul(argv[4]) : 100;
+    uint32_t extra_mobs = argc > 5 ? std::stoul(argv[5]) : 0;
+    //0 uses every core, the state hash must not depend on this
+    uint32_t threads = argc > 6 ? std::stoul(argv[6]) : 0;
+    if (tick_count == 0) return 1;
+    ThreadPool::init(threads);
+
+    srand(seed);
+    Server::game.init();
+    Simulation *sim = &Server::game.simulation;
+    //zone spawn caps keep init() far below ENTITY_CAP, these ignore them
+    for (uint32_t i = 0; i < extra_mobs; ++i) {
+        float x = frand() * ARENA_WIDTH;
+        float y = frand() * ARENA_HEIGHT;
+        struct ZoneDefinition const &zone = MAP_DATA[Map::get_zone_from_pos(x, y)];
+        uint32_t pick = std::min<uint32_t>(frand() * zone.spawns.size(), zone.spawns.size() - 1);
+        alloc_mob(sim, zone.spawns[pick].id, x, y, NULL_ENTITY);
+    }
+    std::vector<Client> clients(player_count);
+    for (Client &client : clients) {
+        client.ws = nullptr;
+        client.verified = 1;
+        client.isAdmin = false;
+        Server::game.add_client(&client);
+    }
+
+    std::vector<uint64_t> samples[TickPhase::kNumPhases];
+    std::vector<uint64_t> totals;
+    for (uint32_t i = 0; i < warmup + tick_count; ++i) {
+        for (Client &client : clients)
+            _drive_player(sim, client);
+        if (i == warmup) {
+            bytes_sent = 0;
+            packet_hash = 14695981039346656037ull;
+        }
+        Server::game.tick();
+        if (i < warmup) continue;
+        TickSample const &sample = TickProfiler::last();
+        uint64_t total = 0;
+        for (uint32_t p = 0; p < TickPhase::kNumPhases; ++p) {
+            samples[p].push_back(sample[p]);
+            total += sample[p];
+        }
+        totals.push_back(total);
+    }
+
+    //fingerprint of the final world state, equal seeds should give equal hashes
+    uint32_t entity_count = 0;
+    uint64_t state_hash = 14695981039346656037ull;
+    sim->for_each_entity([&](Simulation *, Entity &ent) {
+        ++entity_count;
+        state_hash = (state_hash ^ EntityID::make_hash(ent.id)) * 1099511628211ull;
+        if (!ent.has_component(kPhysics)) return;
+        float const values[] = { ent.get_x(), ent.get_y(), ent.health };
+        for (float v : values)
+            state_hash = (state_hash ^ std::bit_cast<uint32_t>(v)) * 1099511628211ull;
+    });
+    std::printf("gardn-bench: %u players, %u ticks (%u warmup), seed %u, %u threads\n", player_count, tick_count, warmup, seed, ThreadPool::size());
+    std::printf("%u entities at end, state hash %016llx\n", entity_count, (unsigned long long) state_hash);
+    std::printf("%.0f bytes sent per tick, packet hash %016llx\n", bytes_sent / (double) tick_count, (unsigned long long) packet_hash);
+    std::printf("%-12s %10s %10s %10s %10s\n", "phase", "mean(us)", "p50(us)", "p99(us)", "max(us)");
+    for (uint32_t p = 0; p < TickPhase::kNumPhases; ++p)
+        _print_row(TickProfiler::PHASE_NAMES[p], samples[p]);
+    _print_row("Total", totals);
+    std::printf("%s", TickProfiler::packet_report().c_str());
+    return 0;
+}
@@ -4,6 +4,7 @@
 #include <Server/PetalTracker.hh>
 #include <Server/Server.hh>
 #include <Server/Spawn.hh>
+#include <Server/TickProfiler.hh>
 
 #include <Helpers/UTF8.hh>
 #include <Server/picosha2.h>
@@ -47,7 +48,7 @@ uint8_t Client::alive() {
 void Client::on_message(WebSocket *ws, std::string_view message, uint64_t code) {
     if (ws == nullptr) return;
     uint8_t const *data = reinterpret_cast<uint8_t const *>(message.data());
-    Reader reader(data);
+    Reader reader(data, data + message.size());
     Validator validator(data, data + message.size());
     Client *client = ws->getUserData();
     if (client == nullptr) {
@@ -89,14 +90,14 @@ void Client::on_message(WebSocket *ws, std::string_view message, uint64_t code)
             )) return;
             float x = reader.read<float>();
             float y = reader.read<float>();
-            if (x == 0 && y == 0) player.acceleration.set(0,0);
+            if (x == 0 && y == 0) player.acceleration().set(0,0);
             else {
                 if (std::abs(x) > 5e3 || std::abs(y) > 5e3) break;
                 Vector accel(x,y);
                 float m = accel.magnitude();
                 if (m > 200) accel.set_magnitude(PLAYER_ACCELERATION);
                 else accel.set_magnitude(m / 200 * PLAYER_ACCELERATION);
-                player.acceleration = accel;
+                player.acceleration() = accel;
             }
             client->mouse_world_x = player.get_x() + x / camera.get_fov();
             client->mouse_world_y = player.get_y() + y / camera.get_fov();
@@ -367,14 +368,11 @@ void Client::command(Client* client, std::string const& text, float mouse_x, flo
         }
     }
     else if (command == "killallmobs") {
-        for (uint16_t i = 0; i < ENTITY_CAP; ++i) {
-            EntityID id(i, 0);
-           // if (!simulation->ent_alive(id)) continue;
-            Entity& ent = simulation->get_ent(id);
-            if (ent.has_component(kMob)) {
-                ent.health = 0;
-            }
-        }
+        //commands run between ticks, the lists may not have mobs spawned since
+        simulation->rebuild_entity_lists();
+        simulation->for_each<kMob>([](Simulation *, Entity &ent) {
+            ent.health = 0;
+        });
     }
     else  if (command == "broadcast") {
         std::string text;
@@ -394,6 +392,20 @@ void Client::command(Client* client, std::string const& text, float mouse_x, flo
     else if (command == "heal") {
         player.health = player.max_health;
     }
+    else if (command == "profile") {
+        uint32_t ticks = 10 * TPS;
+        if (iss >> arg) {
+            try { ticks = uint32_t(std::stoul(arg)); }
+            catch (const std::invalid_argument&) { return; }
+            catch (const std::out_of_range&) { return; }
+        }
+        std::cout << TickProfiler::report(ticks) << TickProfiler::packet_report();
+        Writer writer(Server::OUTGOING_PACKET);
+        writer.write<uint8_t>(Clientbound::kChat);
+        writer.write<EntityID>(player.id);
+        writer.write<std::string>(TickProfiler::summary(ticks));
+        client->send_packet(writer.view());
+    }
     else if (command == "hunter") {
         //ȡ
         std::string arg;
@@ -415,6 +427,7 @@ void Client::command(Client* client, std::string const& text, float mouse_x, flo
         EntityID nearest_flower = NULL_ENTITY;
         float min_dist = std::numeric_limits<float>::max();
 
+        simulation->rebuild_entity_lists();
         simulation->for_each<kFlower>([&](Simulation* sim_ptr, Entity& flower) {
             float dist = Vector(flower.get_x() - x, flower.get_y() - y).magnitude();
             if (dist < min_dist) {
@@ -3,9 +3,12 @@
 #include <Shared/Binary.hh>
 #include <Shared/EntityDef.hh>
 
+#include <Helpers/Bits.hh>
+
 #include <cstdint>
-#include <set>
 #include <string>
+#include <string_view>
+#include <vector>
 
 #ifdef WASM_SERVER
 class WebSocket;
@@ -21,7 +24,17 @@ class Client {
 public:
     GameInstance *game;
     EntityID camera;
-    std::set<EntityID> in_view;
+    //one bit per entity id the client has been sent, and the hash it was
+    //created with. sized on the first update, see Game.cc
+    std::vector<uint64_t> in_view;
+    std::vector<EntityID::hash_type> in_view_hash;
+    //only words [in_view_begin, in_view_end) of in_view can be set
+    uint32_t in_view_begin = 0;
+    uint32_t in_view_end = 0;
+    //whether the last update left <id> on the client's screen
+    bool sees(EntityID const &id) const {
+        return !in_view.empty() && BitMath::at_arr(in_view.data(), id.id) && in_view_hash[id.id] == id.hash;
+    }
     WebSocket *ws;
     uint8_t verified = 0;
     uint8_t seen_arena = 0;
@@ -31,7 +44,7 @@ public:
     void disconnect(int = CloseReason::kProtocol, std::string const & = "Protocol Error");
     uint8_t alive();
     bool isAdmin;
-    void send_packet(uint8_t const *, size_t);
+    void send_packet(std::string_view);
     float mouse_world_x = 0.0f;
     float mouse_world_y = 0.0f;
     //takes in a bool expr
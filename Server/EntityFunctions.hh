@@ -14,4 +14,6 @@ void entity_on_death(Simulation *, Entity const &);
 EntityID find_nearest_enemy(Simulation *, Entity const &, float);
 
 void entity_set_despawn_tick(Entity &, game_tick_t);
+//culled, not accelerating and (almost) at rest, motion and collision leave it frozen
+bool entity_is_dormant(Entity const &);
 void entity_clear_references(Simulation *, Entity &);
@@ -140,8 +140,8 @@ void inflict_damage(Simulation *sim, EntityID const atk_id, EntityID const def_i
                 const int missile_count = 12;
                 const float circle_radius = attacker->get_radius() + 200.0f; // Բ뾶 = ʵ뾶 + 200
                 float prediction_factor = 7.0f;
-                float predicted_x = attacker->get_x() + attacker->velocity.x * prediction_factor;
-                float predicted_y = attacker->get_y() + attacker->velocity.y * prediction_factor;
+                float predicted_x = attacker->get_x() + attacker->velocity().x * prediction_factor;
+                float predicted_y = attacker->get_y() + attacker->velocity().y * prediction_factor;
                 for (int j = 0; j < missile_count; ++j) {
                     float angle = 2.0f * M_PI * j / missile_count;
                     float x = predicted_x + cos(angle) * circle_radius;
@@ -183,7 +183,7 @@ void inflict_damage(Simulation *sim, EntityID const atk_id, EntityID const def_i
                 missile.damage = 1;
                 missile.health = missile.max_health = 5000;
                 missile.set_radius(60);
-                missile.mass = 10;
+                missile.mass() = 10;
                 missile.set_team(defender.get_team());
                 entity_set_despawn_tick(missile, 3 * TPS);
                 missile.set_x(x);
@@ -31,7 +31,7 @@ static void _alloc_drops(Simulation *sim, std::vector<PetalID::T> &success_drops
             Entity &drop = alloc_drop(sim, success_drops[i]);
             drop.set_x(x);
             drop.set_y(y);
-            drop.velocity.unit_normal(i * 2 * M_PI / count).set_magnitude(25);
+            drop.velocity().unit_normal(i * 2 * M_PI / count).set_magnitude(25);
         }
     } else if (count == 1) {
         Entity &drop = alloc_drop(sim, success_drops[0]);
@@ -192,16 +192,13 @@ void entity_on_death(Simulation *sim, Entity const &ent) {
 
             // Ѫ TargetDummy ˺
             Entity* lowest_dummy = nullptr;
-            for (uint16_t i = 0; i < ENTITY_CAP; ++i) {
-                EntityID id(i, 0);
-                if (!sim->ent_exists(id)) continue;
-                Entity& e = sim->get_ent(id);
+            sim->for_each<kMob>([&](Simulation *, Entity &e) {
                 if (e.get_mob_id() == MobID::kTargetDummy) {
                     if (!lowest_dummy || e.health < lowest_dummy->health) {
                         lowest_dummy = &e;
                     }
                 }
-            }
+            });
 
             if (lowest_dummy) {
                 lowest_dummy->health = (lowest_dummy->health >= 2000) ? lowest_dummy->health - 2000 : 0;
@@ -10,6 +10,20 @@ void entity_set_despawn_tick(Entity &ent, game_tick_t t) {
     BitMath::set(ent.flags, EntityFlags::kIsDespawning);
 }
 
+//slower than this a culled mob just stops, nobody is close enough to see it drift
+static float const DORMANT_SPEED = 0.01;
+
+bool entity_is_dormant(Entity const &ent) {
+#ifdef NO_SIMULATION_LOD
+    return false;
+#else
+    if (!BitMath::at(ent.flags, EntityFlags::kIsCulled)) return false;
+    if (!(ent.acceleration().x == 0 && ent.acceleration().y == 0)) return false;
+    if (!(ent.collision_velocity().x == 0 && ent.collision_velocity().y == 0)) return false;
+    return ent.velocity().x * ent.velocity().x + ent.velocity().y * ent.velocity().y < DORMANT_SPEED * DORMANT_SPEED;
+#endif
+}
+
 template<typename T, typename U>
 class FilterCast {
 public:
@@ -25,12 +39,12 @@ public:
 };
 
 void entity_clear_references(Simulation *sim, Entity &ent) {
-#define SINGLE(component, name, type) \
+#define SINGLE(component, name, type, wire) \
 if constexpr (std::is_same_v<type, EntityID>) { \
     if (ent.has_component(k##component) && !sim->ent_exists(FilterCast<EntityID, type>::get(ent.get_##name()))) \
         ent.set_##name(FilterCast<type, EntityID>::get(NULL_ENTITY)); \
 }
-#define MULTIPLE(component, name, type, count)
+#define MULTIPLE(component, name, type, count, wire)
 PERFIELD
 #undef SINGLE
 #undef MULTIPLE
@@ -4,69 +4,323 @@
 #include <Server/PetalTracker.hh>
 #include <Server/Server.hh>
 #include <Server/Spawn.hh>
+#include <Server/ThreadPool.hh>
+#include <Server/TickProfiler.hh>
 #include <Shared/Binary.hh>
 #include <Shared/Entity.hh>
 #include <Shared/Map.hh>
 
-static void _update_client(Simulation *sim, Client *client) {
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <deque>
+#include <string_view>
+#include <vector>
+
+static uint32_t const VIEW_WORDS = div_round_up(ENTITY_CAP, 64);
+//payloads are encoded in chunks of this many view words, one arena per chunk
+static uint32_t const PAYLOAD_CHUNK_WORDS = 8;
+static uint32_t const PAYLOAD_CHUNKS = div_round_up(VIEW_WORDS, PAYLOAD_CHUNK_WORDS);
+
+//entities every client sees wherever its camera is, collected once per tick
+static std::vector<EntityID> target_dummies;
+//team and id of every flower, teammates are always in view
+static std::vector<std::pair<EntityID, EntityID>> team_flowers;
+
+//replication runs in three passes, the first and last one per client and
+//in parallel: every client's view is built, the payloads any view needs are
+//encoded, then every packet is written from those. sockets are only touched
+//afterwards, from the thread that ticks the game
+struct ClientView {
+    Client *client;
+    uint8_t active;
+    //only words [begin, end) of bits can be set, so a view over a small
+    //part of the map doesn't walk the whole id range
+    uint32_t begin;
+    uint32_t end;
+    std::array<uint64_t, VIEW_WORDS> bits;
+    //the part of bits that gets a create, the rest gets deltas
+    std::array<uint64_t, VIEW_WORDS> creates;
+    //kept between ticks, so it only grows when a bigger packet comes along
+    std::vector<uint8_t> packet;
+    std::string_view message;
+};
+
+//a deque, so adding a client doesn't copy every other view
+static std::deque<ClientView> views;
+
+//union of every view, split the same way, set only in [need_begin, need_end)
+static std::array<uint64_t, VIEW_WORDS> need_delta;
+static std::array<uint64_t, VIEW_WORDS> need_create;
+static uint32_t need_begin = 0;
+static uint32_t need_end = 0;
+
+//entity payloads are encoded once per tick and copied into every packet
+//that needs them. deltas only hold for the tick, create fields hold while
+//the entity's snapshot_version does
+struct DeltaPayload {
+    uint32_t offset;
+    uint32_t size;
+};
+
+//stamp is 0 if the fields were clean when encoded, otherwise only the
+//tick they were encoded in can use them. version 0 is never handed out,
+//so it marks a slot without a payload
+struct CreatePayload {
+    uint64_t version;
+    uint64_t stamp;
+    uint32_t offset;
+    uint32_t size;
+};
+
+//create fields outlive the tick, so a chunk's arena is appended to and only
+//compacted once it has grown to twice what was live after the last time
+struct CreateArena {
+    std::vector<uint8_t> bytes;
+    uint32_t compacted_size;
+};
+
+//arenas smaller than this are never compacted
+static uint32_t const CREATE_ARENA_SLACK = 16 * 1024;
+
+static std::array<std::vector<uint8_t>, PAYLOAD_CHUNKS> delta_bytes;
+static std::array<DeltaPayload, ENTITY_CAP> delta_payloads;
+static std::array<CreateArena, PAYLOAD_CHUNKS> create_bytes;
+static std::array<CreatePayload, ENTITY_CAP> create_payloads;
+//64 bits, so it never wraps and a stale stamp can never match again
+static uint64_t payload_generation = 0;
+
+//encoding buffer of the calling thread
+static std::vector<uint8_t> &_scratch() {
+    static thread_local std::vector<uint8_t> buffer;
+    return buffer;
+}
+
+static void _view_add(ClientView &view, EntityID const &id) {
+    BitMath::set_arr(view.bits.data(), id.id);
+    uint32_t const w = id.id / 64;
+    view.begin = std::min(view.begin, w);
+    view.end = std::max(view.end, w + 1);
+}
+
+static void _collect_always_visible(Simulation *sim) {
+    target_dummies.clear();
+    team_flowers.clear();
+    sim->for_each<kMob>([&](Simulation*, Entity& ent) {
+        if (ent.get_mob_id() == MobID::kTargetDummy)
+            target_dummies.push_back(ent.id);
+    });
+    sim->for_each<kFlower>([&](Simulation*, Entity& ent) {
+        team_flowers.push_back({ ent.get_team(), ent.id });
+    });
+}
+
+static void _build_view(Simulation *sim, ClientView &view) {
+    Client *client = view.client;
+    view.active = 0;
     if (client == nullptr) return;
     if (!client->verified) return;
     if (sim == nullptr) return;
     if (!sim->ent_exists(client->camera)) return;
-    std::set<EntityID> in_view;
-    std::vector<EntityID> deletes;
-    in_view.insert(client->camera);
+    //once active a client gets an update every tick until its camera is gone,
+    //Wire::Position deltas rely on that
+    if (client->in_view.empty()) {
+        client->in_view.assign(VIEW_WORDS, 0);
+        client->in_view_hash.assign(ENTITY_CAP, 0);
+    }
+    view.active = 1;
+    std::fill(view.bits.begin() + view.begin, view.bits.begin() + view.end, 0);
+    view.begin = VIEW_WORDS;
+    view.end = 0;
+    _view_add(view, client->camera);
     Entity &camera = sim->get_ent(client->camera);
     if (sim->ent_exists(camera.get_player())) 
-        in_view.insert(camera.get_player());
-    Writer writer(Server::OUTGOING_PACKET);
-    writer.write<uint8_t>(Clientbound::kClientUpdate);
-    writer.write<EntityID>(client->camera);
+        _view_add(view, camera.get_player());
     sim->spatial_hash.query(camera.get_camera_x(), camera.get_camera_y(), 
     960 / camera.get_fov() + 50, 540 / camera.get_fov() + 50, [&](Simulation *, Entity &ent){
-        in_view.insert(ent.id);
+        _view_add(view, ent.id);
     });
 
-    sim->for_each<kMob>([&](Simulation*, Entity& ent) {
-        if (ent.get_mob_id() == MobID::kTargetDummy) {
-            in_view.insert(ent.id);
+    for (EntityID const &id : target_dummies)
+        _view_add(view, id);
+
+    for (auto const &[team, id] : team_flowers) {
+        if (id != client->camera && team == camera.get_team())
+            _view_add(view, id);
+    }
+
+    //a create for anything the client hasn't seen, or saw in a reused slot
+    for (uint32_t w = view.begin; w < view.end; ++w) {
+        uint64_t const now = view.bits[w];
+        uint64_t const seen = client->in_view[w];
+        uint64_t creates = now & ~seen;
+        for (uint64_t both = now & seen; both != 0; both &= both - 1) {
+            uint32_t const bit = std::countr_zero(both);
+            uint32_t const id = w * 64 + bit;
+            if (client->in_view_hash[id] != sim->hash_of(id)) BitMath::set(creates, bit);
         }
-    });
+        view.creates[w] = creates;
+    }
+}
 
-    sim->for_each<kFlower>([&](Simulation*, Entity& ent) {
-        if (ent.id != client->camera && ent.get_team() == camera.get_team()) {
-            in_view.insert(ent.id);
+static void _collect_payload_needs() {
+    if (need_begin < need_end) {
+        std::fill(need_delta.begin() + need_begin, need_delta.begin() + need_end, 0);
+        std::fill(need_create.begin() + need_begin, need_create.begin() + need_end, 0);
+    }
+    need_begin = VIEW_WORDS;
+    need_end = 0;
+    for (ClientView const &view : views) {
+        if (!view.active) continue;
+        need_begin = std::min(need_begin, view.begin);
+        need_end = std::max(need_end, view.end);
+        for (uint32_t w = view.begin; w < view.end; ++w) {
+            need_delta[w] |= view.bits[w] & ~view.creates[w];
+            need_create[w] |= view.creates[w];
         }
-    });
+    }
+}
 
-    for (EntityID const &i: client->in_view) {
-        if (!in_view.contains(i)) {
-            writer.write<EntityID>(i);
-            deletes.push_back(i);
+//keeps only the payloads their entity can still use, which also frees the
+//bytes of deleted entities
+static void _compact_create_arena(Simulation *sim, uint32_t chunk) {
+    CreateArena &arena = create_bytes[chunk];
+    std::vector<uint8_t> live;
+    live.reserve(arena.compacted_size);
+    uint32_t const end = std::min(ENTITY_CAP, (chunk + 1) * PAYLOAD_CHUNK_WORDS * 64);
+    for (uint32_t id = chunk * PAYLOAD_CHUNK_WORDS * 64; id < end; ++id) {
+        CreatePayload &payload = create_payloads[id];
+        if (payload.version == 0) continue;
+        EntityID const ent_id(id, sim->hash_of(id));
+        if (!sim->ent_exists(ent_id) || sim->get_ent(ent_id).snapshot_version != payload.version
+            || (payload.stamp != 0 && payload.stamp != payload_generation)) {
+            payload = {};
+            continue;
         }
+        uint8_t const *start = arena.bytes.data() + payload.offset;
+        payload.offset = live.size();
+        live.insert(live.end(), start, start + payload.size);
     }
+    arena.bytes = std::move(live);
+    arena.compacted_size = arena.bytes.size();
+}
 
-    for (EntityID const &i : deletes)
-        client->in_view.erase(i);
+static void _encode_payloads(Simulation *sim, uint32_t chunk) {
+    std::vector<uint8_t> &bytes = delta_bytes[chunk];
+    bytes.clear();
+    CreateArena &arena = create_bytes[chunk];
+    std::vector<uint8_t> &scratch = _scratch();
+    uint32_t const end = std::min(need_end, (chunk + 1) * PAYLOAD_CHUNK_WORDS);
+    for (uint32_t w = std::max(need_begin, chunk * PAYLOAD_CHUNK_WORDS); w < end; ++w) {
+        for (uint64_t bits = need_delta[w]; bits != 0; bits &= bits - 1) {
+            uint32_t const id = w * 64 + std::countr_zero(bits);
+            Entity &ent = sim->get_ent(EntityID(id, sim->hash_of(id)));
+            Writer writer(scratch);
+            ent.write(&writer, 0);
+            delta_payloads[id] = { (uint32_t) bytes.size(), (uint32_t) (writer.at - writer.packet) };
+            bytes.insert(bytes.end(), writer.packet, writer.at);
+        }
+        for (uint64_t bits = need_create[w]; bits != 0; bits &= bits - 1) {
+            uint32_t const id = w * 64 + std::countr_zero(bits);
+            Entity &ent = sim->get_ent(EntityID(id, sim->hash_of(id)));
+            CreatePayload &payload = create_payloads[id];
+            uint64_t const stamp = ent.has_dirty_fields() ? payload_generation : 0;
+            if (payload.version == ent.snapshot_version && payload.stamp == stamp) continue;
+            Writer writer(scratch);
+            ent.write_create_fields(&writer);
+            payload = { ent.snapshot_version, stamp, (uint32_t) arena.bytes.size(), (uint32_t) (writer.at - writer.packet) };
+            arena.bytes.insert(arena.bytes.end(), writer.packet, writer.at);
+        }
+    }
+    if (arena.bytes.size() > 2 * arena.compacted_size + CREATE_ARENA_SLACK)
+        _compact_create_arena(sim, chunk);
+}
+
+static void _write_update(Simulation *sim, ClientView &view) {
+    if (!view.active) return;
+    Client *client = view.client;
+    Writer writer(view.packet);
+    writer.write<uint8_t>(Clientbound::kClientUpdate);
+    writer.write<EntityID>(client->camera);
+    //every word this or the last update could have set
+    uint32_t const begin = std::min(view.begin, client->in_view_begin);
+    uint32_t const end = std::max(view.end, client->in_view_end);
+
+    //deletes, in id order
+    for (uint32_t w = begin; w < end; ++w) {
+        uint64_t const now = view.bits[w];
+        for (uint64_t seen = client->in_view[w]; seen != 0; seen &= seen - 1) {
+            uint32_t const bit = std::countr_zero(seen);
+            uint32_t const id = w * 64 + bit;
+            //still in view as the same entity, not a new one in a reused slot
+            if (BitMath::at(now, bit) && sim->hash_of(id) == client->in_view_hash[id]) continue;
+            writer.write<EntityID>(EntityID(id, client->in_view_hash[id]));
+        }
+    }
 
     writer.write<EntityID>(NULL_ENTITY);
     //upcreates
-    for (EntityID id: in_view) {
-        DEBUG_ONLY(assert(sim->ent_exists(id));)
-        Entity &ent = sim->get_ent(id);
-        uint8_t create = !client->in_view.contains(id);
-        writer.write<EntityID>(id);
-        writer.write<uint8_t>(create | (ent.pending_delete << 1));
-        ent.write(&writer, BitMath::at(create, 0));
-        client->in_view.insert(id);
+    for (uint32_t w = begin; w < end; ++w) {
+        uint64_t const now = view.bits[w];
+        for (uint64_t bits = now; bits != 0; bits &= bits - 1) {
+            uint32_t const bit = std::countr_zero(bits);
+            uint32_t const id = w * 64 + bit;
+            EntityID const ent_id(id, sim->hash_of(id));
+            DEBUG_ONLY(assert(sim->ent_exists(ent_id));)
+            Entity &ent = sim->get_ent(ent_id);
+            uint8_t create = BitMath::at(view.creates[w], bit);
+            writer.write<EntityID>(ent_id);
+            writer.write<uint8_t>(create | (ent.pending_delete << 1));
+            if (create) {
+                ent.write_create_header(&writer);
+                CreatePayload const &payload = create_payloads[id];
+                writer.write_bytes(create_bytes[w / PAYLOAD_CHUNK_WORDS].bytes.data() + payload.offset, payload.size);
+            } else {
+                DeltaPayload const &payload = delta_payloads[id];
+                writer.write_bytes(delta_bytes[w / PAYLOAD_CHUNK_WORDS].data() + payload.offset, payload.size);
+            }
+            client->in_view_hash[id] = ent_id.hash;
+        }
+        client->in_view[w] = now;
     }
+    client->in_view_begin = view.begin;
+    client->in_view_end = view.end;
    
     writer.write<EntityID>(NULL_ENTITY);
     //write arena stuff
     writer.write<uint8_t>(client->seen_arena);
     sim->arena_info.write(&writer, client->seen_arena);
     client->seen_arena = 1;
-    client->send_packet(writer.packet, writer.at - writer.packet);
+    view.message = writer.view();
+}
+
+static void _update_clients(Simulation *sim, std::set<Client *> const &clients) {
+    views.resize(clients.size());
+    uint32_t n = 0;
+    for (Client *client : clients) views[n++].client = client;
+    ++payload_generation;
+    //the sorted backend sorts on the first query, which must not race
+    sim->spatial_hash.finish_inserts();
+    if constexpr (SpatialHash::PARALLEL_QUERY) {
+        ThreadPool::parallel_for(views.size(), [&](uint32_t i) {
+            _build_view(sim, views[i]);
+        });
+    } else {
+        for (ClientView &view : views)
+            _build_view(sim, view);
+    }
+    _collect_payload_needs();
+    ThreadPool::parallel_for(PAYLOAD_CHUNKS, [&](uint32_t chunk) {
+        _encode_payloads(sim, chunk);
+    });
+    ThreadPool::parallel_for(views.size(), [&](uint32_t i) {
+        _write_update(sim, views[i]);
+    });
+    for (ClientView const &view : views) {
+        if (!view.active) continue;
+        TickProfiler::record_packet(view.message.size());
+        view.client->send_packet(view.message);
+    }
 }
 
 GameInstance::GameInstance() : simulation(), clients(), team_manager(&simulation) {}
@@ -89,10 +343,14 @@ void GameInstance::init() {
 }
 
 void GameInstance::tick() {
+    TickProfiler::begin();
     simulation.tick();
-    for (Client *client : clients)
-        _update_client(&simulation, client);
+    _collect_always_visible(&simulation);
+    _update_clients(&simulation, clients);
+    TickProfiler::lap(TickPhase::kReplication);
     simulation.post_tick();
+    TickProfiler::lap(TickPhase::kPostTick);
+    TickProfiler::end();
 }
 
 void GameInstance::add_client(Client *client) {
@@ -102,6 +360,13 @@ void GameInstance::add_client(Client *client) {
     client->game = this;
     clients.insert(client);
     Entity &ent = simulation.alloc_ent();
+    //the world is full, the client reconnects and tries again
+    if (ent.id == NULL_ENTITY) {
+        client->camera = NULL_ENTITY;
+        remove_client(client);
+        client->disconnect(CloseReason::kServer, "Server Full");
+        return;
+    }
     ent.add_component(kCamera);
     ent.add_component(kRelations);
     #ifdef GAMEMODE_TDM
@@ -173,6 +438,7 @@ void GameInstance::chat(EntityID sender, std::string const& text) {
         // жͬӺӾ
         Simulation* sim = &simulation;
         if (!sim->ent_exists(sender)) continue;
+        if (!sim->ent_exists(client->camera)) continue;
 
         Entity& sender_ent = sim->get_ent(sender);
         Entity& camera = sim->get_ent(client->camera);
@@ -181,7 +447,7 @@ void GameInstance::chat(EntityID sender, std::string const& text) {
         if (sender_ent.get_team() == camera.get_team()) {
             send = true; // ͬԶɼ
         }
-        else if (client->in_view.contains(sender_ent.id)) {
+        else if (client->sees(sender_ent.id)) {
             send = true;
         }
 
@@ -190,7 +456,7 @@ void GameInstance::chat(EntityID sender, std::string const& text) {
             writer.write<uint8_t>(Clientbound::kChat);
             writer.write<EntityID>(sender);   // ʵ ID
             writer.write<std::string>(text);
-            client->send_packet(writer.packet, writer.at - writer.packet);
+            client->send_packet(writer.view());
         }
     }
 }
@@ -202,6 +468,6 @@ void GameInstance::broadcast_message(std::string const& msg) {
         writer.write<uint8_t>(Clientbound::kBroadcast); // ö
         writer.write<std::string>(msg);
 
-        client->send_packet(writer.packet, writer.at - writer.packet);
+        client->send_packet(writer.view());
     }
 }
\ No newline at end of file
@@ -2,8 +2,21 @@
 #include <Server/Server.hh>
 
 #include <Server/Client.hh>
+#include <Server/TickProfiler.hh>
 #include <Shared/Config.hh>
 
+#include <charconv>
+
+static bool _is_loopback(std::string_view addr) {
+    //uWS hands out the raw 4 or 16 byte address
+    if (addr.size() == 4) return addr[0] == 127;
+    if (addr.size() != 16) return false;
+    static const char v6_loopback[16] = { 0,0,0,0, 0,0,0,0, 0,0,0,0, 0,0,0,1 };
+    static const char v4_mapped[12] = { 0,0,0,0, 0,0,0,0, 0,0,(char)0xff,(char)0xff };
+    if (addr == std::string_view(v6_loopback, 16)) return true;
+    return addr.substr(0, 12) == std::string_view(v4_mapped, 12) && addr[12] == 127;
+}
+
 uWS::App Server::server = uWS::App({
     .key_file_name = "misc/key.pem",
     .cert_file_name = "misc/cert.pem",
@@ -44,6 +57,16 @@ uWS::App Server::server = uWS::App({
     .close = [](WebSocket *ws, int code, std::string_view message) {
         Client::on_disconnect(ws, code, message);
     }
+}).get("/profile", [](auto *res, auto *req) {
+    //tick phase timings for operators, e.g. curl localhost:<port>/profile?ticks=200
+    if (!_is_loopback(res->getRemoteAddress())) {
+        res->writeStatus("403 Forbidden")->end();
+        return;
+    }
+    uint32_t ticks = PROFILER_HISTORY;
+    std::string_view query = req->getQuery("ticks");
+    std::from_chars(query.data(), query.data() + query.size(), ticks);
+    res->writeHeader("Content-Type", "text/plain")->end(TickProfiler::report(ticks) + TickProfiler::packet_report());
 }).listen(SERVER_PORT, [](auto *listen_socket) {
     if (listen_socket) {
         std::cout << "Listening on port " << SERVER_PORT << std::endl;
@@ -58,9 +81,8 @@ void Server::run() {
     Server::server.run();
 }
 
-void Client::send_packet(uint8_t const *packet, size_t size) {
+void Client::send_packet(std::string_view message) {
     if (ws == nullptr) return;
-    std::string_view message(reinterpret_cast<char const *>(packet), size);
     ws->send(message, uWS::OpCode::BINARY, 0);
 }
 #endif
\ No newline at end of file
@@ -2,15 +2,33 @@
 #include <Server/Server.hh>
 #include <Server/EntityFunctions.hh>
 #include <Server/Spawn.hh>
+#include <Server/ThreadPool.hh>
 #include <Shared/Entity.hh>
 #include <Shared/Simulation.hh>
 #include <Shared/StaticData.hh>
+#include <algorithm>
+#include <bit>
 #include <map>
 #include <cmath>
+#include <vector>
 
 
 static std::map<EntityID::id_type, uint32_t> ai_chat_cooldowns;
 
+//every AI draw comes from the mob's own stream, reseeded from its id and age
+//before each of its ticks. no draw depends on which thread runs the mob or
+//on how many other mobs drew before it
+static thread_local SeedGenerator ai_rng(0);
+
+static float ai_rand() {
+    return ai_rng.next();
+}
+
+static void _seed_ai_rand(Entity const &ent) {
+    uint32_t seed = ent.id.id * 0x9e3779b1u ^ ent.id.hash * 0x85ebca77u ^ ent.lifetime * 0xc2b2ae3du;
+    ai_rng = SeedGenerator(seed ^ (seed >> 15));
+}
+
 static void _focus_lose_clause(Entity &ent, Vector const &v) {
     if (v.magnitude() > 1.5 * ent.detection_radius) ent.target = NULL_ENTITY;
 }
@@ -18,7 +36,7 @@ static void _focus_lose_clause(Entity &ent, Vector const &v) {
 static void default_tick_idle(Simulation *sim, Entity &ent) {
     if (ent.ai_tick >= 1 * TPS) {
         ent.ai_tick = 0;
-        ent.set_angle(frand() * 2 * M_PI);
+        ent.set_angle(ai_rand() * 2 * M_PI);
         ent.ai_state = AIState::kIdleMoving;
     }
 }
@@ -31,7 +49,7 @@ static void default_tick_idle_moving(Simulation *sim, Entity &ent) {
     }
     if (ent.ai_tick < 0.5 * TPS) return;
     float r = (ent.ai_tick - 0.5 * TPS) / (2 * TPS);
-    ent.acceleration
+    ent.acceleration()
         .unit_normal(ent.get_angle())
         .set_magnitude(2 * PLAYER_ACCELERATION * (r - r * r));
 }
@@ -52,7 +70,7 @@ static void default_tick_returning(Simulation *sim, Entity &ent, float speed = 1
         return;
     } 
     delta.set_magnitude(PLAYER_ACCELERATION * speed);
-    ent.acceleration = delta;
+    ent.acceleration() = delta;
     ent.set_angle(delta.angle());
 }
 
@@ -82,7 +100,7 @@ static void tick_default_neutral(Simulation *sim, Entity &ent) {
         Entity &target = sim->get_ent(ent.target);
         Vector v(target.get_x() - ent.get_x(), target.get_y() - ent.get_y());
         v.set_magnitude(PLAYER_ACCELERATION * 0.975);
-        ent.acceleration = v;
+        ent.acceleration() = v;
         ent.set_angle(v.angle());
         return;
     } else {
@@ -101,7 +119,7 @@ static void tick_default_aggro(Simulation *sim, Entity &ent, float speed) {
         Vector v(target.get_x() - ent.get_x(), target.get_y() - ent.get_y());
         _focus_lose_clause(ent, v);
         v.set_magnitude(PLAYER_ACCELERATION * speed);
-        ent.acceleration = v;
+        ent.acceleration() = v;
         ent.set_angle(v.angle());
         return;
     } else {
@@ -120,7 +138,7 @@ static void tick_bee_passive(Simulation *sim, Entity &ent) {
         case AIState::kIdle: {
             if (ent.ai_tick >= 5 * TPS) {
                 ent.ai_tick = 0;
-                ent.set_angle(frand() * 2 * M_PI);
+                ent.set_angle(ai_rand() * 2 * M_PI);
                 ent.ai_state = AIState::kIdle;
             }
             ent.set_angle(ent.get_angle() + 1.5 * sinf(((float) ent.lifetime) / (TPS / 2)) / TPS);
@@ -128,7 +146,7 @@ static void tick_bee_passive(Simulation *sim, Entity &ent) {
             v *= 1.5;
             if (ent.lifetime % (TPS * 3 / 2) < TPS / 2)
                 v *= 0.5;
-            ent.acceleration = v;
+            ent.acceleration() = v;
             break;
         }
         case AIState::kIdleMoving: {
@@ -152,9 +170,9 @@ static void tick_hornet_aggro(Simulation *sim, Entity &ent) {
         float dist = v.magnitude();
         if (dist > 300) {
             v.set_magnitude(PLAYER_ACCELERATION * 0.975);
-            ent.acceleration = v;
+            ent.acceleration() = v;
         } else {
-            ent.acceleration.set(0,0);
+            ent.acceleration().set(0,0);
         }
         ent.set_angle(v.angle());
         if (ent.ai_tick >= 1.5 * TPS && dist < 800) {
@@ -167,10 +185,10 @@ static void tick_hornet_aggro(Simulation *sim, Entity &ent) {
             //missile.despawn_tick = 1;
             entity_set_despawn_tick(missile, 3 * TPS);
             missile.set_angle(ent.get_angle());
-            missile.acceleration.unit_normal(ent.get_angle()).set_magnitude(40 * PLAYER_ACCELERATION);
+            missile.acceleration().unit_normal(ent.get_angle()).set_magnitude(40 * PLAYER_ACCELERATION);
             Vector kb;
             kb.unit_normal(ent.get_angle() - M_PI).set_magnitude(2.5 * PLAYER_ACCELERATION);
-            ent.velocity += kb;            
+            ent.velocity() += kb;            
         }
         return;
     } else {
@@ -184,109 +202,188 @@ static void tick_hornet_aggro(Simulation *sim, Entity &ent) {
     }
 }
 
-static void tick_tank_aggro(Simulation* sim, Entity& ent) {
-    if (sim->ent_alive(ent.target)) {
-        Entity& target = sim->get_ent(ent.target);
-        Vector v(target.get_x() - ent.get_x(), target.get_y() - ent.get_y());
-        _focus_lose_clause(ent, v);
-        float dist = v.magnitude();
+//everything the bullet lead of a tank depends on
+struct TankAim {
+    EntityID target;
+    float x;
+    float y;
+    float angle;
+    float radius;
+    float target_x;
+    float target_y;
+    float target_vx;
+    float target_vy;
+    float target_ax;
+    float target_ay;
+    float target_friction;
+    float target_speed_ratio;
+    game_tick_t target_slow_ticks;
+    //bitwise, a defaulted == would mix up -0 and +0 and never match a NaN
+    bool operator==(TankAim const &o) const {
+        auto same = [](float a, float b) { return std::bit_cast<uint32_t>(a) == std::bit_cast<uint32_t>(b); };
+        return target == o.target && same(x, o.x) && same(y, o.y)
+            && same(angle, o.angle) && same(radius, o.radius)
+            && same(target_x, o.target_x) && same(target_y, o.target_y)
+            && same(target_vx, o.target_vx) && same(target_vy, o.target_vy)
+            && same(target_ax, o.target_ax) && same(target_ay, o.target_ay)
+            && same(target_friction, o.target_friction)
+            && same(target_speed_ratio, o.target_speed_ratio)
+            && target_slow_ticks == o.target_slow_ticks;
+    }
+};
+
+//lead angles worked out by tick_ai_think, sorted by tank id. a tank only uses
+//its guess if the inputs are still exactly the same when its turn comes
+struct TankGuess {
+    EntityID::id_type tank;
+    TankAim aim;
+    float angle;
+};
+
+static std::vector<TankGuess> tank_guesses;
+
+static TankAim _tank_aim(Entity const &ent, Entity const &target) {
+    return {
+        .target = target.id,
+        .x = ent.get_x(),
+        .y = ent.get_y(),
+        .angle = ent.get_angle(),
+        .radius = ent.get_radius(),
+        .target_x = target.get_x(),
+        .target_y = target.get_y(),
+        .target_vx = target.velocity().x,
+        .target_vy = target.velocity().y,
+        .target_ax = target.acceleration().x,
+        .target_ay = target.acceleration().y,
+        .target_friction = target.friction(),
+        .target_speed_ratio = target.speed_ratio(),
+        .target_slow_ticks = target.slow_ticks
+    };
+}
 
+//angle a bullet has to leave at to meet the target, only reads <aim>
+static float _tank_lead_angle(TankAim const &aim) {
+    const float BULLET_ACCEL = 4.0f * PLAYER_ACCELERATION;
+    const float BULLET_FRICTION = DEFAULT_FRICTION * 1.5f;
+    const float offset = aim.radius * 1.8f;
+    const int MAX_ITERATIONS = 50;
 
-        if (dist < 380) {
-            v.set_magnitude(-PLAYER_ACCELERATION * 0.35f);
-            ent.acceleration = v;
-        }
-        else if (dist > 400) {
-            v.set_magnitude(PLAYER_ACCELERATION * 0.975f);
-            ent.acceleration = v;
-        }
-        else {
-            Vector circle_v(v.y, -v.x); 
-            circle_v.set_magnitude(PLAYER_ACCELERATION * 0.7f);
-            ent.acceleration = circle_v;
-        }
+    Vector const target_acceleration(aim.target_ax, aim.target_ay);
 
+    Vector spawn_offset;
+    spawn_offset.unit_normal(aim.angle).set_magnitude(offset);
+    Vector bullet_spawn_pos(aim.x + spawn_offset.x, aim.y + spawn_offset.y);
 
-        const float BULLET_ACCEL = 4.0f * PLAYER_ACCELERATION;
-        const float BULLET_FRICTION = DEFAULT_FRICTION * 1.5f;
-        const float offset = ent.get_radius() * 1.8f;
-        const int MAX_ITERATIONS = 50;
 
+    Vector simulated_target_pos = Vector(aim.target_x, aim.target_y);
+    Vector simulated_target_vel = Vector(aim.target_vx, aim.target_vy);
+    int simulated_target_slow_ticks = aim.target_slow_ticks;
 
-        Vector spawn_offset;
-        spawn_offset.unit_normal(ent.get_angle()).set_magnitude(offset);
-        Vector bullet_spawn_pos(ent.get_x() + spawn_offset.x, ent.get_y() + spawn_offset.y);
+    float lower_bound = 0.0f;
+    float upper_bound = (Vector(aim.target_x, aim.target_y) - bullet_spawn_pos).magnitude() / 10.0f;
 
 
-        Vector simulated_target_pos = Vector(target.get_x(), target.get_y());
-        Vector simulated_target_vel = Vector(target.velocity.x, target.velocity.y);
-        int simulated_target_slow_ticks = target.slow_ticks;
+    for (int i = 0; i < MAX_ITERATIONS; ++i) {
+        float mid_time = (lower_bound + upper_bound) / 2.0f;
+        if (mid_time < 0.01f) {
+            break;
+        }
 
-        float lower_bound = 0.0f;
-        float upper_bound = (Vector(target.get_x(), target.get_y()) - bullet_spawn_pos).magnitude() / 10.0f;
 
+        Vector current_target_pos = simulated_target_pos;
+        Vector current_target_vel = simulated_target_vel;
+        int current_target_slow_ticks = simulated_target_slow_ticks;
 
-        for (int i = 0; i < MAX_ITERATIONS; ++i) {
-            float mid_time = (lower_bound + upper_bound) / 2.0f;
-            if (mid_time < 0.01f) {
-                break;
-            }
+        Vector current_bullet_vel = Vector(0, 0);
+        Vector current_bullet_pos = bullet_spawn_pos;
 
 
-            Vector current_target_pos = simulated_target_pos;
-            Vector current_target_vel = simulated_target_vel;
-            int current_target_slow_ticks = simulated_target_slow_ticks;
+        Vector temp_predicted_v = Vector(current_target_pos.x - aim.x, current_target_pos.y - aim.y);
 
-            Vector current_bullet_vel = Vector(0, 0);
-            Vector current_bullet_pos = bullet_spawn_pos;
+        for (int frame = 0; frame < (int)ceil(mid_time); ++frame) {
+            if (current_target_slow_ticks > 0) {
+                current_target_vel *= 0.5f;
+                current_target_slow_ticks--;
+            }
+            current_target_vel *= (1.0f - aim.target_friction);
+            current_target_vel += target_acceleration * aim.target_speed_ratio;
+            current_target_pos += current_target_vel;
 
+            current_bullet_vel *= (1.0f - BULLET_FRICTION);
+            current_bullet_vel += temp_predicted_v.unit_normal(temp_predicted_v.angle()) * BULLET_ACCEL * 1.0f; 
+            current_bullet_pos += current_bullet_vel;
+        }
 
-            Vector temp_predicted_v = Vector(current_target_pos.x - ent.get_x(), current_target_pos.y - ent.get_y());
+        float target_dist = (current_target_pos - bullet_spawn_pos).magnitude();
+        float bullet_dist = (current_bullet_pos - bullet_spawn_pos).magnitude();
 
-            for (int frame = 0; frame < (int)ceil(mid_time); ++frame) {
-                if (current_target_slow_ticks > 0) {
-                    current_target_vel *= 0.5f;
-                    current_target_slow_ticks--;
-                }
-                current_target_vel *= (1.0f - target.friction);
-                current_target_vel += target.acceleration * target.speed_ratio;
-                current_target_pos += current_target_vel;
+        if (bullet_dist > target_dist) {
+            upper_bound = mid_time;
+        }
+        else {
+            lower_bound = mid_time;
+        }
+    }
 
-                current_bullet_vel *= (1.0f - BULLET_FRICTION);
-                current_bullet_vel += temp_predicted_v.unit_normal(temp_predicted_v.angle()) * BULLET_ACCEL * 1.0f; 
-                current_bullet_pos += current_bullet_vel;
-            }
 
-            float target_dist = (current_target_pos - bullet_spawn_pos).magnitude();
-            float bullet_dist = (current_bullet_pos - bullet_spawn_pos).magnitude();
+    float final_flight_time = lower_bound;
+    Vector final_target_pos = simulated_target_pos;
+    Vector final_target_vel = simulated_target_vel;
+    int final_target_slow_ticks = simulated_target_slow_ticks;
 
-            if (bullet_dist > target_dist) {
-                upper_bound = mid_time;
-            }
-            else {
-                lower_bound = mid_time;
-            }
+    for (int frame = 0; frame < (int)ceil(final_flight_time); ++frame) {
+        if (final_target_slow_ticks > 0) {
+            final_target_vel *= 0.5f;
+            final_target_slow_ticks--;
         }
+        final_target_vel *= (1.0f - aim.target_friction);
+        final_target_vel += target_acceleration * aim.target_speed_ratio;
+        final_target_pos += final_target_vel;
+    }
 
 
-        float final_flight_time = lower_bound;
-        Vector final_target_pos = simulated_target_pos;
-        Vector final_target_vel = simulated_target_vel;
-        int final_target_slow_ticks = simulated_target_slow_ticks;
+    Vector predicted_v(final_target_pos.x - aim.x, final_target_pos.y - aim.y);
+    return predicted_v.angle();
+}
 
-        for (int frame = 0; frame < (int)ceil(final_flight_time); ++frame) {
-            if (final_target_slow_ticks > 0) {
-                final_target_vel *= 0.5f;
-                final_target_slow_ticks--;
-            }
-            final_target_vel *= (1.0f - target.friction);
-            final_target_vel += target.acceleration * target.speed_ratio;
-            final_target_pos += final_target_vel;
+static float _guess_lead_angle(Entity const &ent, Entity const &target) {
+    TankAim const aim = _tank_aim(ent, target);
+    auto iter = std::lower_bound(tank_guesses.begin(), tank_guesses.end(), ent.id.id,
+        [](TankGuess const &guess, EntityID::id_type id) { return guess.tank < id; });
+    if (iter != tank_guesses.end() && iter->tank == ent.id.id && iter->aim == aim)
+        return iter->angle;
+    return _tank_lead_angle(aim);
+}
+
+static void tick_tank_aggro(Simulation* sim, Entity& ent) {
+    if (sim->ent_alive(ent.target)) {
+        Entity& target = sim->get_ent(ent.target);
+        Vector v(target.get_x() - ent.get_x(), target.get_y() - ent.get_y());
+        _focus_lose_clause(ent, v);
+        float dist = v.magnitude();
+
+
+        if (dist < 380) {
+            v.set_magnitude(-PLAYER_ACCELERATION * 0.35f);
+            ent.acceleration() = v;
+        }
+        else if (dist > 400) {
+            v.set_magnitude(PLAYER_ACCELERATION * 0.975f);
+            ent.acceleration() = v;
+        }
+        else {
+            Vector circle_v(v.y, -v.x); 
+            circle_v.set_magnitude(PLAYER_ACCELERATION * 0.7f);
+            ent.acceleration() = circle_v;
         }
 
 
-        Vector predicted_v(final_target_pos.x - ent.get_x(), final_target_pos.y - ent.get_y());
-        ent.set_angle(predicted_v.angle());
+        const float BULLET_ACCEL = 4.0f * PLAYER_ACCELERATION;
+        const float offset = ent.get_radius() * 1.8f;
+
+
+        float const lead_angle = _guess_lead_angle(ent, target);
+        ent.set_angle(lead_angle);
 
 
         if (ent.ai_tick >= 0.5f * TPS && dist < 800) {
@@ -297,19 +394,19 @@ static void tick_tank_aggro(Simulation* sim, Entity& ent) {
             bullet.health = bullet.max_health = 10;
             bullet.set_radius(ent.get_radius() * 0.4f);
 
-            bullet.set_angle(predicted_v.angle());
+            bullet.set_angle(lead_angle);
 
             Vector spawn_offset_bullet;
             spawn_offset_bullet.unit_normal(ent.get_angle()).set_magnitude(offset);
             bullet.set_x(ent.get_x() + spawn_offset_bullet.x);
             bullet.set_y(ent.get_y() + spawn_offset_bullet.y);
 
-            bullet.acceleration.unit_normal(predicted_v.angle()).set_magnitude(BULLET_ACCEL);
+            bullet.acceleration().unit_normal(lead_angle).set_magnitude(BULLET_ACCEL);
 
 
             Vector kb;
             kb.unit_normal(ent.get_angle() - M_PI).set_magnitude(2.5f * PLAYER_ACCELERATION);
-            ent.velocity += kb;
+            ent.velocity() += kb;
         }
 
         return;
@@ -350,7 +447,7 @@ static void tick_fallenflower_bbht(Simulation* sim, Entity& ent) {
                 int best_iter = -1;
 
                 Vector simulated_target_pos(target.get_x(), target.get_y());
-                Vector simulated_target_vel(target.velocity.x, target.velocity.y);
+                Vector simulated_target_vel(target.velocity().x, target.velocity().y);
                 int MAX_ITER = 20;
                 float BULLET_SPEED = 4.0f * PLAYER_ACCELERATION;
                 Vector spawn_pos(dandelion.get_x(), dandelion.get_y());
@@ -378,7 +475,7 @@ static void tick_fallenflower_bbht(Simulation* sim, Entity& ent) {
                         dandelion.secondary_reload > PETAL_DATA[dandelion.get_petal_id()].attributes.secondary_reload * TPS)
                     {
                         BitMath::set(ent.input, InputFlags::kAttacking);
-                        dandelion.acceleration.unit_normal(best_predicted_v.angle()).set_magnitude(4 * PLAYER_ACCELERATION);
+                        dandelion.acceleration().unit_normal(best_predicted_v.angle()).set_magnitude(4 * PLAYER_ACCELERATION);
                         entity_set_despawn_tick(dandelion, 3 * TPS);
                     }
                 }
@@ -518,7 +615,7 @@ static void tick_fallenflower_bbht(Simulation* sim, Entity& ent) {
 
         v.unit_normal(v.angle()).set_magnitude(PLAYER_ACCELERATION);
 
-        ent.acceleration = v;
+        ent.acceleration() = v;
         ent.set_angle(v.angle());
         return;
     }
@@ -531,7 +628,7 @@ static void tick_fallenflower_bbht(Simulation* sim, Entity& ent) {
         ent.target = find_nearest_enemy(sim, ent, ent.detection_radius + ent.get_radius());
         switch (ent.ai_state) {
         case AIState::kIdle: {
-            ent.set_angle(frand() * M_PI * 2);
+            ent.set_angle(ai_rand() * M_PI * 2);
             ent.ai_state = AIState::kIdleMoving;
             ent.ai_tick = 0;
             break;
@@ -539,7 +636,7 @@ static void tick_fallenflower_bbht(Simulation* sim, Entity& ent) {
         case AIState::kIdleMoving: {
             if (ent.ai_tick > 5 * TPS)
                 ent.ai_state = AIState::kIdle;
-            ent.acceleration.unit_normal(ent.get_angle()).set_magnitude(PLAYER_ACCELERATION);
+            ent.acceleration().unit_normal(ent.get_angle()).set_magnitude(PLAYER_ACCELERATION);
             break;
         }
         case AIState::kReturning: {
@@ -575,7 +672,7 @@ static void tick_fallenflower_wheel(Simulation* sim, Entity& ent) {
                 int best_iter = -1;
 
                 Vector simulated_target_pos(target.get_x(), target.get_y());
-                Vector simulated_target_vel(target.velocity.x, target.velocity.y);
+                Vector simulated_target_vel(target.velocity().x, target.velocity().y);
                 int MAX_ITER = 20;
                 float BULLET_SPEED = 4.0f * PLAYER_ACCELERATION;
                 Vector spawn_pos(dandelion.get_x(), dandelion.get_y());
@@ -603,7 +700,7 @@ static void tick_fallenflower_wheel(Simulation* sim, Entity& ent) {
                         dandelion.secondary_reload > PETAL_DATA[dandelion.get_petal_id()].attributes.secondary_reload * TPS)
                     {
                         BitMath::set(ent.input, InputFlags::kAttacking);
-                        dandelion.acceleration.unit_normal(best_predicted_v.angle()).set_magnitude(4 * PLAYER_ACCELERATION);
+                        dandelion.acceleration().unit_normal(best_predicted_v.angle()).set_magnitude(4 * PLAYER_ACCELERATION);
                         entity_set_despawn_tick(dandelion, 3 * TPS);
                     }
                 }
@@ -617,7 +714,7 @@ static void tick_fallenflower_wheel(Simulation* sim, Entity& ent) {
             if (player_to_target_dist <= ent.get_radius() + 80.0f) {
                 ent.input = 0;
             }
-            Vector target_vel = target.velocity;
+            Vector target_vel = target.velocity();
             float dot = v.x * target_vel.x + v.y * target_vel.y;
             float min_dist = ent.get_radius() + 180.0f;
             if (dot < 0 && player_to_target_dist < ent.get_radius() + 360.0f) {
@@ -674,7 +771,7 @@ static void tick_fallenflower_wheel(Simulation* sim, Entity& ent) {
 
         v.unit_normal(v.angle()).set_magnitude(PLAYER_ACCELERATION);
 
-        ent.acceleration = v;
+        ent.acceleration() = v;
         ent.set_angle(v.angle());
         return;
     }
@@ -687,7 +784,7 @@ static void tick_fallenflower_wheel(Simulation* sim, Entity& ent) {
         ent.target = find_nearest_enemy(sim, ent, ent.detection_radius + ent.get_radius());
         switch (ent.ai_state) {
         case AIState::kIdle: {
-            ent.set_angle(frand() * M_PI * 2);
+            ent.set_angle(ai_rand() * M_PI * 2);
             ent.ai_state = AIState::kIdleMoving;
             ent.ai_tick = 0;
             break;
@@ -695,7 +792,7 @@ static void tick_fallenflower_wheel(Simulation* sim, Entity& ent) {
         case AIState::kIdleMoving: {
             if (ent.ai_tick > 5 * TPS)
                 ent.ai_state = AIState::kIdle;
-            ent.acceleration.unit_normal(ent.get_angle()).set_magnitude(PLAYER_ACCELERATION);
+            ent.acceleration().unit_normal(ent.get_angle()).set_magnitude(PLAYER_ACCELERATION);
             break;
         }
         case AIState::kReturning: {
@@ -710,12 +807,12 @@ static void tick_centipede_passive(Simulation *sim, Entity &ent) {
     switch(ent.ai_state) {
         case AIState::kIdle: {
             ent.set_angle(ent.get_angle() + 0.25 / TPS);
-            if (frand() < 1 / (5.0 * TPS)) ent.ai_state = AIState::kIdleMoving;
+            if (ai_rand() < 1 / (5.0 * TPS)) ent.ai_state = AIState::kIdleMoving;
             break;
         }
         case AIState::kIdleMoving: {
             ent.set_angle(ent.get_angle() - 0.25 / TPS);
-            if (frand() < 1 / (5.0 * TPS)) ent.ai_state = AIState::kIdle;
+            if (ai_rand() < 1 / (5.0 * TPS)) ent.ai_state = AIState::kIdle;
             break;
         }
         case AIState::kReturning: {
@@ -723,7 +820,7 @@ static void tick_centipede_passive(Simulation *sim, Entity &ent) {
             break;
         }
     }
-    ent.acceleration.unit_normal(ent.get_angle()).set_magnitude(PLAYER_ACCELERATION / 10);
+    ent.acceleration().unit_normal(ent.get_angle()).set_magnitude(PLAYER_ACCELERATION / 10);
 }
 
 static void tick_centipede_neutral(Simulation *sim, Entity &ent, float speed) {
@@ -731,7 +828,7 @@ static void tick_centipede_neutral(Simulation *sim, Entity &ent, float speed) {
         Entity &target = sim->get_ent(ent.target);
         Vector v(target.get_x() - ent.get_x(), target.get_y() - ent.get_y());
         v.set_magnitude(PLAYER_ACCELERATION * speed);
-        ent.acceleration = v;
+        ent.acceleration() = v;
         ent.set_angle(v.angle());
         return;
     } else {
@@ -742,14 +839,14 @@ static void tick_centipede_neutral(Simulation *sim, Entity &ent, float speed) {
         switch(ent.ai_state) {
             case AIState::kIdle: {
                 ent.set_angle(ent.get_angle() + 0.25 / TPS);
-                if (frand() < 1 / (5.0 * TPS)) ent.ai_state = AIState::kIdleMoving;
-                ent.acceleration.unit_normal(ent.get_angle()).set_magnitude(PLAYER_ACCELERATION * speed);
+                if (ai_rand() < 1 / (5.0 * TPS)) ent.ai_state = AIState::kIdleMoving;
+                ent.acceleration().unit_normal(ent.get_angle()).set_magnitude(PLAYER_ACCELERATION * speed);
                 break;
             }
             case AIState::kIdleMoving: {
                 ent.set_angle(ent.get_angle() - 0.25 / TPS);
-                if (frand() < 1 / (5.0 * TPS)) ent.ai_state = AIState::kIdle;
-                ent.acceleration.unit_normal(ent.get_angle()).set_magnitude(PLAYER_ACCELERATION * speed);
+                if (ai_rand() < 1 / (5.0 * TPS)) ent.ai_state = AIState::kIdle;
+                ent.acceleration().unit_normal(ent.get_angle()).set_magnitude(PLAYER_ACCELERATION * speed);
                 break;
             }
             case AIState::kReturning: {
@@ -766,7 +863,7 @@ static void tick_centipede_aggro(Simulation *sim, Entity &ent) {
         Vector v(target.get_x() - ent.get_x(), target.get_y() - ent.get_y());
         _focus_lose_clause(ent, v);
         v.set_magnitude(PLAYER_ACCELERATION * 0.95);
-        ent.acceleration = v;
+        ent.acceleration() = v;
         ent.set_angle(v.angle());
         return;
     } else {
@@ -778,14 +875,14 @@ static void tick_centipede_aggro(Simulation *sim, Entity &ent) {
         switch(ent.ai_state) {
             case AIState::kIdle: {
                 ent.set_angle(ent.get_angle() + 0.25 / TPS);
-                if (frand() < 1 / (5.0 * TPS)) ent.ai_state = AIState::kIdleMoving;
-                ent.acceleration.unit_normal(ent.get_angle()).set_magnitude(PLAYER_ACCELERATION / 10);
+                if (ai_rand() < 1 / (5.0 * TPS)) ent.ai_state = AIState::kIdleMoving;
+                ent.acceleration().unit_normal(ent.get_angle()).set_magnitude(PLAYER_ACCELERATION / 10);
                 break;
             }
             case AIState::kIdleMoving: {
                 ent.set_angle(ent.get_angle() - 0.25 / TPS);
-                if (frand() < 1 / (5.0 * TPS)) ent.ai_state = AIState::kIdle;
-                ent.acceleration.unit_normal(ent.get_angle()).set_magnitude(PLAYER_ACCELERATION / 10);
+                if (ai_rand() < 1 / (5.0 * TPS)) ent.ai_state = AIState::kIdle;
+                ent.acceleration().unit_normal(ent.get_angle()).set_magnitude(PLAYER_ACCELERATION / 10);
                 break;
             }
             case AIState::kReturning: {
@@ -799,13 +896,14 @@ static void tick_centipede_aggro(Simulation *sim, Entity &ent) {
 static void tick_sandstorm(Simulation *sim, Entity &ent) {
     switch(ent.ai_state) {
         case AIState::kIdle: {
-            if (frand() > 1.0f / TPS) {
+            if (ai_rand() > 1.0f / TPS) {
                 ent.ai_tick = 0;
-                ent.heading_angle = frand() * 2 * M_PI;
+                ent.heading_angle = ai_rand() * 2 * M_PI;
                 ent.ai_state = AIState::kIdleMoving;
             }
-            Vector rand = Vector::rand(PLAYER_ACCELERATION * 0.5);
-            ent.acceleration.set(rand.x, rand.y);
+            Vector rand;
+            rand.unit_normal(ai_rand() * 2 * M_PI).set_magnitude(PLAYER_ACCELERATION * 0.5);
+            ent.acceleration().set(rand.x, rand.y);
             break;
         }
         case AIState::kIdleMoving: {
@@ -813,16 +911,16 @@ static void tick_sandstorm(Simulation *sim, Entity &ent) {
                 ent.ai_tick = 0;
                 ent.ai_state = AIState::kIdle;
             }
-            if (frand() > 2.5f / TPS)
-                ent.heading_angle += frand() * M_PI - M_PI / 2;
+            if (ai_rand() > 2.5f / TPS)
+                ent.heading_angle += ai_rand() * M_PI - M_PI / 2;
             Vector head;
             head.unit_normal(ent.heading_angle);
             head.set_magnitude(PLAYER_ACCELERATION);
             Vector rand;
-            rand.unit_normal(ent.heading_angle + frand() * M_PI - M_PI / 2);
+            rand.unit_normal(ent.heading_angle + ai_rand() * M_PI - M_PI / 2);
             rand.set_magnitude(PLAYER_ACCELERATION * 0.5);
             head += rand;
-            ent.acceleration.set(head.x, head.y);
+            ent.acceleration().set(head.x, head.y);
             break;
         }
         case AIState::kReturning: {
@@ -835,7 +933,7 @@ static void tick_sandstorm(Simulation *sim, Entity &ent) {
     }
     if (sim->ent_alive(ent.get_parent())) {
         Entity &parent = sim->get_ent(ent.get_parent());
-        ent.acceleration = (ent.acceleration + parent.acceleration) * 0.75;
+        ent.acceleration() = (ent.acceleration() + parent.acceleration()) * 0.75;
     }
 }
 
@@ -852,7 +950,7 @@ static void tick_digger(Simulation *sim, Entity &ent) {
             BitMath::set(ent.input, InputFlags::kDefending);
             v *= -1;
         }
-        ent.acceleration = v;
+        ent.acceleration() = v;
         ent.set_angle(v.angle());
         return;
     } else {
@@ -864,7 +962,7 @@ static void tick_digger(Simulation *sim, Entity &ent) {
         ent.target = find_nearest_enemy(sim, ent, ent.detection_radius + ent.get_radius());
         switch(ent.ai_state) {
             case AIState::kIdle: {
-                ent.set_angle(frand() * M_PI * 2);
+                ent.set_angle(ai_rand() * M_PI * 2);
                 ent.ai_state = AIState::kIdleMoving;
                 ent.ai_tick = 0;
                 break;
@@ -872,7 +970,7 @@ static void tick_digger(Simulation *sim, Entity &ent) {
             case AIState::kIdleMoving: {
                 if (ent.ai_tick > 5 * TPS)
                     ent.ai_state = AIState::kIdle;
-                ent.acceleration.unit_normal(ent.get_angle()).set_magnitude(PLAYER_ACCELERATION);
+                ent.acceleration().unit_normal(ent.get_angle()).set_magnitude(PLAYER_ACCELERATION);
                 break;
             }
             case AIState::kReturning: {
@@ -883,46 +981,10 @@ static void tick_digger(Simulation *sim, Entity &ent) {
     }
 }
 
-void tick_ai_behavior(Simulation *sim, Entity &ent) {
-    if (ent.prey != NULL_ENTITY) {
-        if (sim->ent_alive(ent.prey)) {
-            ent.target = ent.prey; // 直接追 prey
-            BitMath::unset(ent.flags, EntityFlags::kIsCulled);
-        }
-        else {
-            ent.health = 0;        // prey 死亡，自身也死亡
-        }
-    }
-    if (ent.pending_delete) return;
-    if (sim->ent_alive(ent.seg_head)) return;
-    ent.acceleration.set(0,0);
-    if (!(ent.get_parent() == NULL_ENTITY)) {
-        if (!sim->ent_alive(ent.get_parent())) {
-            if (BitMath::at(ent.flags, EntityFlags::kDieOnParentDeath))
-                sim->request_delete(ent.id);
-            ent.set_parent(NULL_ENTITY);
-        } else {
-            Entity const &parent = sim->get_ent(ent.get_parent());
-            Vector delta(parent.get_x() - ent.get_x(), parent.get_y() - ent.get_y());
-            if (delta.magnitude() > SUMMON_RETREAT_RADIUS) {
-                ent.target = NULL_ENTITY;
-                ent.ai_state = AIState::kReturning;
-            }
-            if (sim->ent_alive(ent.target)) {
-                Entity const &target = sim->get_ent(ent.target);
-                delta = Vector(parent.get_x() - target.get_x(), parent.get_y() - target.get_y());
-                if (delta.magnitude() > SUMMON_RETREAT_RADIUS)
-                    ent.target = NULL_ENTITY;
-            }
-        }
-    }
-    if (BitMath::at(ent.flags, EntityFlags::kIsCulled)) {
-        ent.target = NULL_ENTITY;
-        ent.ai_tick = 0;
-        return;
-    }
-    if (!sim->ent_alive(ent.target) && sim->ent_alive(ent.last_damaged_by))
-        ent.target = ent.last_damaged_by;
+//the per-type state machine, wall avoidance and ai_tick for a mob that passed
+//_tick_ai_prelude. spawns are left to _tick_ai_spawns
+static void _tick_ai_state(Simulation *sim, Entity &ent) {
+    _seed_ai_rand(ent);
     switch(ent.get_mob_id()) {
         case MobID::kBabyAnt:            
         case MobID::kLadybug:
@@ -955,19 +1017,9 @@ void tick_ai_behavior(Simulation *sim, Entity &ent) {
             tick_default_aggro(sim, ent, 0.975);
             break;
         case MobID::kSpider:
-            if (ent.lifetime % (TPS) == 0) 
-                alloc_web(sim, 25, ent);
             tick_default_aggro(sim, ent, 0.975);
             break;
         case MobID::kQueenAnt:
-            if (ent.lifetime % (2 * TPS) == 0) {
-                Vector behind;
-                behind.unit_normal(ent.get_angle() + M_PI);
-                behind *= ent.get_radius();
-                Entity &spawned = alloc_mob(sim, MobID::kSoldierAnt, ent.get_x() + behind.x, ent.get_y() + behind.y, ent.get_team());
-                entity_set_despawn_tick(spawned, 10 * TPS);
-                spawned.set_parent(ent.get_parent());
-            }
             tick_default_aggro(sim, ent, 0.95);
             break;
         case MobID::kHornet:
@@ -1010,7 +1062,7 @@ void tick_ai_behavior(Simulation *sim, Entity &ent) {
             uint32_t& chat_cooldown = ai_chat_cooldowns[ent.id.id];
 
             if (chat_cooldown == 0) {
-                size_t idx = (size_t)std::floor(frand() * chat_messages.size());
+                size_t idx = (size_t)std::floor(ai_rand() * chat_messages.size());
                 const std::string& msg = chat_messages[idx];
 
                 Server::game.chat(ent.id, msg);
@@ -1037,4 +1089,139 @@ void tick_ai_behavior(Simulation *sim, Entity &ent) {
             ent.set_angle(0 - ent.get_angle());
     }
     ++ent.ai_tick;
+}
+
+//whether a mob's state machine only reads other entities and only writes to
+//the mob itself, so any number of them can run at once. the rest spawn, chat,
+//push themselves back or follow another mob's acceleration
+static uint8_t _ai_state_is_local(MobID::T mob_id) {
+    switch (mob_id) {
+        case MobID::kHornet:
+        case MobID::kTank:
+        case MobID::kSandstorm:
+        case MobID::kFallenFlower:
+            return 0;
+        default:
+            return 1;
+    }
+}
+
+//spawns of the mobs whose state machine is otherwise local
+static void _tick_ai_spawns(Simulation *sim, Entity &ent) {
+    switch(ent.get_mob_id()) {
+        case MobID::kSpider:
+            if (ent.lifetime % (TPS) == 0) 
+                alloc_web(sim, 25, ent);
+            break;
+        case MobID::kQueenAnt:
+            if (ent.lifetime % (2 * TPS) == 0) {
+                Vector behind;
+                behind.unit_normal(ent.get_angle() + M_PI);
+                behind *= ent.get_radius();
+                Entity &spawned = alloc_mob(sim, MobID::kSoldierAnt, ent.get_x() + behind.x, ent.get_y() + behind.y, ent.get_team());
+                entity_set_despawn_tick(spawned, 10 * TPS);
+                spawned.set_parent(ent.get_parent());
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+//prey, parent and culling checks, which read what earlier mobs decided here,
+//so they stay serial. returns whether the mob gets a state machine tick
+static uint8_t _tick_ai_prelude(Simulation *sim, Entity &ent) {
+    if (ent.prey != NULL_ENTITY) {
+        if (sim->ent_alive(ent.prey)) {
+            ent.target = ent.prey; // 直接追 prey
+            BitMath::unset(ent.flags, EntityFlags::kIsCulled);
+        }
+        else {
+            ent.health = 0;        // prey 死亡，自身也死亡
+        }
+    }
+    if (ent.pending_delete) return 0;
+    if (sim->ent_alive(ent.seg_head)) return 0;
+    ent.acceleration().set(0,0);
+    if (!(ent.get_parent() == NULL_ENTITY)) {
+        if (!sim->ent_alive(ent.get_parent())) {
+            if (BitMath::at(ent.flags, EntityFlags::kDieOnParentDeath))
+                sim->request_delete(ent.id);
+            ent.set_parent(NULL_ENTITY);
+        } else {
+            Entity const &parent = sim->get_ent(ent.get_parent());
+            Vector delta(parent.get_x() - ent.get_x(), parent.get_y() - ent.get_y());
+            if (delta.magnitude() > SUMMON_RETREAT_RADIUS) {
+                ent.target = NULL_ENTITY;
+                ent.ai_state = AIState::kReturning;
+            }
+            if (sim->ent_alive(ent.target)) {
+                Entity const &target = sim->get_ent(ent.target);
+                delta = Vector(parent.get_x() - target.get_x(), parent.get_y() - target.get_y());
+                if (delta.magnitude() > SUMMON_RETREAT_RADIUS)
+                    ent.target = NULL_ENTITY;
+            }
+        }
+    }
+    if (BitMath::at(ent.flags, EntityFlags::kIsCulled)) {
+        ent.target = NULL_ENTITY;
+        ent.ai_tick = 0;
+        return 0;
+    }
+    if (!sim->ent_alive(ent.target) && sim->ent_alive(ent.last_damaged_by))
+        ent.target = ent.last_damaged_by;
+    return 1;
+}
+
+//mobs that passed the prelude this tick, in id order
+static std::vector<EntityID> ai_thinkers;
+//the ones of those whose state machine is local, run on the pool
+static std::vector<EntityID> ai_local_thinkers;
+
+//mobs and tanks that get worked out by the same pool task
+static uint32_t const AI_THINK_CHUNK = 64;
+static uint32_t const TANK_GUESS_CHUNK = 8;
+
+void tick_ai_think(Simulation *sim) {
+    ai_thinkers.clear();
+    ai_local_thinkers.clear();
+    uint8_t any_owned = 0;
+    sim->for_each<kMob>([&](Simulation *sim, Entity &ent) {
+        if (!_tick_ai_prelude(sim, ent)) return;
+        ai_thinkers.push_back(ent.id);
+        if (!_ai_state_is_local(ent.get_mob_id())) return;
+        ai_local_thinkers.push_back(ent.id);
+        if (!ent.get_team().null()) any_owned = 1;
+    });
+    //team-owned mobs query the wild targets, which are otherwise sorted lazily
+    if (any_owned) sim->targets.sort_wild();
+    ThreadPool::parallel_for(div_round_up(ai_local_thinkers.size(), AI_THINK_CHUNK), [&](uint32_t chunk) {
+        uint32_t const end = std::min<uint32_t>((chunk + 1) * AI_THINK_CHUNK, ai_local_thinkers.size());
+        for (uint32_t i = chunk * AI_THINK_CHUNK; i < end; ++i)
+            _tick_ai_state(sim, sim->get_ent(ai_local_thinkers[i]));
+    });
+    //after the local mobs moved, so targets that are mobs have their final
+    //acceleration. ai_thinkers is in id order, so tank_guesses is sorted
+    tank_guesses.clear();
+    for (EntityID const &id : ai_thinkers) {
+        Entity const &ent = sim->get_ent(id);
+        if (ent.get_mob_id() != MobID::kTank) continue;
+        if (!sim->ent_alive(ent.target)) continue;
+        tank_guesses.push_back({ id.id, _tank_aim(ent, sim->get_ent(ent.target)), 0 });
+    }
+    ThreadPool::parallel_for(div_round_up(tank_guesses.size(), TANK_GUESS_CHUNK), [](uint32_t chunk) {
+        uint32_t const end = std::min<uint32_t>((chunk + 1) * TANK_GUESS_CHUNK, tank_guesses.size());
+        for (uint32_t i = chunk * TANK_GUESS_CHUNK; i < end; ++i)
+            tank_guesses[i].angle = _tank_lead_angle(tank_guesses[i].aim);
+    });
+}
+
+void tick_ai_behavior(Simulation *sim) {
+    for (EntityID const &id : ai_thinkers) {
+        Entity &ent = sim->get_ent(id);
+        if (_ai_state_is_local(ent.get_mob_id()))
+            _tick_ai_spawns(sim, ent);
+        else
+            _tick_ai_state(sim, ent);
+    }
 }
\ No newline at end of file
@@ -11,8 +11,8 @@ void tick_camera_behavior(Simulation *sim, Entity &ent) {
         ent.set_camera_x(player.get_x());
         ent.set_camera_y(player.get_y());
         player.set_loadout_count(loadout_slots_at_level(score_to_level(player.get_score())));
-        if (player.acceleration.x != 0 || player.acceleration.y != 0)
-            player.set_angle(player.acceleration.angle());
+        if (player.acceleration().x != 0 || player.acceleration().y != 0)
+            player.set_angle(player.acceleration().angle());
 
         ent.last_damaged_by = player.last_damaged_by;
         struct ZoneDefinition const &zone = MAP_DATA[Map::get_zone_from_pos(player.get_x(), player.get_y())];
@@ -1,10 +1,18 @@
+#include <Server/Process.hh>
+
 #include <Server/EntityFunctions.hh>
+#include <Server/ThreadPool.hh>
 
 #include <Shared/Simulation.hh>
 #include <Shared/Entity.hh>
 
+#include <Helpers/Simd.hh>
+
+#include <array>
+#include <bit>
 #include <cmath>
 #include <iostream>
+#include <vector>
 
 static bool _should_interact(Entity const &ent1, Entity const &ent2) {
     //if (ent1.has_component(kFlower) || ent2.has_component(kFlower)) return false;
@@ -44,26 +52,26 @@ static void _pickup_drop(Simulation *sim, Entity &player, Entity &drop) {
 static void _deal_push(Entity &ent, Vector knockback, float mass_ratio, float scale) {
     if (fabsf(mass_ratio) < 0.01) return;
     knockback *= scale * mass_ratio;
-    ent.collision_velocity += knockback;
+    ent.collision_velocity() += knockback;
 }
 
 static void _deal_knockback(Entity &ent, Vector knockback, float mass_ratio) {
     if (fabsf(mass_ratio) < 0.01) return;
     float scale = PLAYER_ACCELERATION * 2;
     knockback *= scale * mass_ratio;
-    ent.collision_velocity += knockback;
-    ent.velocity += knockback * 2;
+    ent.collision_velocity() += knockback;
+    ent.velocity() += knockback * 2;
 }
 
 static void _cancel_movement(Entity &ent, Vector dir, Vector add) {
     Vector push = dir;
     push.normalize();
     float dot = fclamp(push.x * add.x + push.y * add.y, PLAYER_ACCELERATION * 0.5, PLAYER_ACCELERATION * 25);
-    ent.velocity += push * (PLAYER_ACCELERATION + dot * 2);
-    ent.collision_velocity += push * (0.5 * PLAYER_ACCELERATION);
+    ent.velocity() += push * (PLAYER_ACCELERATION + dot * 2);
+    ent.collision_velocity() += push * (0.5 * PLAYER_ACCELERATION);
 }
 
-void on_collide(Simulation *sim, Entity &ent1, Entity &ent2) {
+static void on_collide(Simulation *sim, Entity &ent1, Entity &ent2) {
     //do a distance dependent check first (it's faster)
     float min_dist = ent1.get_radius() + ent2.get_radius();
     if (fabs(ent1.get_x() - ent2.get_x()) > min_dist || fabs(ent1.get_y() - ent2.get_y()) > min_dist) return;
@@ -78,14 +86,14 @@ void on_collide(Simulation *sim, Entity &ent1, Entity &ent2) {
             separation.unit_normal(frand() * 2 * M_PI);
         else
             separation.normalize();
-        float ratio = ent2.mass / (ent1.mass + ent2.mass);
+        float ratio = ent2.mass() / (ent1.mass() + ent2.mass());
         if (!(ent1.get_team() == ent2.get_team())) {
             if (ent1.has_component(kFlower) && !ent2.has_component(kPetal))
-                _cancel_movement(ent1, separation, ent2.velocity - ent1.velocity);
+                _cancel_movement(ent1, separation, ent2.velocity() - ent1.velocity());
             else
                 _deal_knockback(ent1, separation, ratio);
             if (ent2.has_component(kFlower) && !ent1.has_component(kPetal))
-                _cancel_movement(ent2, separation*-1, ent1.velocity - ent2.velocity);
+                _cancel_movement(ent2, separation*-1, ent1.velocity() - ent2.velocity());
             else
                 _deal_knockback(ent2, separation*-1, 1 - ratio);
         }
@@ -108,21 +116,158 @@ void on_collide(Simulation *sim, Entity &ent1, Entity &ent2) {
         _pickup_drop(sim, ent1, ent2);
 
     if (ent1.has_component(kWeb) && !ent2.has_component(kPetal) && !ent2.has_component(kDrop))
-        ent2.speed_ratio *= 0.75;
+        ent2.speed_ratio() *= 0.75;
     if (ent2.has_component(kWeb) && !ent1.has_component(kPetal) && !ent1.has_component(kDrop))
-        ent1.speed_ratio *= 0.75;
+        ent1.speed_ratio() *= 0.75;
     if (ent1.has_component(kPoisonWeb) && !ent2.has_component(kPetal) && !ent2.has_component(kDrop)) {
-        ent2.speed_ratio *= 0.75;
+        ent2.speed_ratio() *= 0.75;
         if (ent2.poison_ticks == 0) {
             ent2.poison_ticks = TPS / 2;
             inflict_damage(sim, sim->get_ent(ent1.get_parent()).get_parent(), ent2.id, 5 / 2, DamageType::kPoison);
         }
     }
     if (ent2.has_component(kPoisonWeb) && !ent1.has_component(kPetal) && !ent1.has_component(kDrop)) {
-        ent1.speed_ratio *= 0.75;
+        ent1.speed_ratio() *= 0.75;
         if (ent1.poison_ticks == 0) {
             ent1.poison_ticks = TPS / 2;
             inflict_damage(sim, sim->get_ent(ent2.get_parent()).get_parent(), ent1.id, 5 / 2, DamageType::kPoison);
         }
     }
-}
\ No newline at end of file
+}
+//everything _should_interact looks at except pending_delete, which can
+//change while pairs are resolved, packed into a few bits per entity
+namespace PairKind {
+    enum : uint8_t {
+        kMob = 1 << 0,
+        kFlower = 1 << 1,
+        kDrop = 1 << 2,
+        kRedFlower = 1 << 3,
+        kTargetDummy = 1 << 4,
+        kNoFriendlyCollision = 1 << 5,
+        kNumKinds = 1 << 6,
+        //not part of INTERACT_TABLE, two dormant mobs are left overlapping
+        //until one of them wakes up, see entity_is_dormant
+        kDormant = 1 << 7
+    };
+};
+
+static constexpr bool _kinds_interact(uint8_t kind1, uint8_t kind2, bool same_team) {
+    if (((kind1 & PairKind::kRedFlower) && (kind2 & PairKind::kDrop)) ||
+        ((kind2 & PairKind::kRedFlower) && (kind1 & PairKind::kDrop))) return false;
+    if (!same_team) return true;
+    if ((kind1 | kind2) & PairKind::kNoFriendlyCollision) return false;
+    if ((kind1 & PairKind::kMob) && (kind2 & PairKind::kMob)) return true;
+    if (((kind1 & PairKind::kFlower) && (kind2 & PairKind::kTargetDummy)) ||
+        ((kind2 & PairKind::kFlower) && (kind1 & PairKind::kTargetDummy))) return true;
+    return false;
+}
+
+//indexed by same_team << 12 | kind1 << 6 | kind2
+static constexpr std::array<uint8_t, 2 * PairKind::kNumKinds * PairKind::kNumKinds> INTERACT_TABLE = [](){
+    std::array<uint8_t, 2 * PairKind::kNumKinds * PairKind::kNumKinds> table = {};
+    for (uint32_t i = 0; i < table.size(); ++i)
+        table[i] = _kinds_interact((i >> 6) & 63, i & 63, i >> 12);
+    return table;
+}();
+
+//refreshed at the start of every collision pass
+static std::array<uint32_t, ENTITY_CAP> pair_team;
+static std::array<uint8_t, ENTITY_CAP> pair_kind;
+
+//candidate pairs from the broadphase are buffered, a pair only reaches
+//on_collide if the circles may touch and the kinds can interact. the circle
+//test has some slack, on_collide still does the exact one
+static uint32_t const PAIR_CHUNK = 256;
+static_assert(PAIR_CHUNK % LANES == 0);
+
+//the broadphase and the pair filter run in column stripes on the thread pool,
+//more stripes than threads so one crowded stripe doesn't hold up the rest
+//on_collide changes velocities, health and entity lists, so the surviving
+//pairs are resolved afterwards on one thread, stripe by stripe, which is the
+//same order a single collide() would give
+static uint32_t const COLLISION_STRIPES = 32;
+
+struct PairBatch {
+    EntityID ent1[PAIR_CHUNK];
+    EntityID ent2[PAIR_CHUNK];
+    float dx[PAIR_CHUNK];
+    float dy[PAIR_CHUNK];
+    float min_dist[PAIR_CHUNK];
+    uint8_t interacts[PAIR_CHUNK];
+    uint32_t count;
+    //pairs that passed the filter, ent1 and ent2 interleaved
+    std::vector<EntityID> hits;
+};
+
+static std::array<PairBatch, COLLISION_STRIPES> stripes;
+
+static void _flush_pairs(PairBatch &pairs) {
+    uint32_t const count = pairs.count;
+    for (; pairs.count % LANES != 0; ++pairs.count) {
+        uint32_t const i = pairs.count;
+        pairs.dx[i] = pairs.dy[i] = 1;
+        pairs.min_dist[i] = 0;
+        pairs.interacts[i] = 0;
+    }
+    lane_t const slack = _splat(1.0001f);
+    lane_t const epsilon = _splat(1e-6f);
+    for (uint32_t i = 0; i < count; i += LANES) {
+        lane_t dx = _load(pairs.dx + i);
+        lane_t dy = _load(pairs.dy + i);
+        lane_t min_dist = _load(pairs.min_dist + i);
+        uint32_t touching = _le_mask(_add(_mul(dx, dx), _mul(dy, dy)), _add(_mul(_mul(min_dist, min_dist), slack), epsilon));
+        for (; touching != 0; touching &= touching - 1) {
+            uint32_t const at = i + std::countr_zero(touching);
+            if (!pairs.interacts[at]) continue;
+            pairs.hits.push_back(pairs.ent1[at]);
+            pairs.hits.push_back(pairs.ent2[at]);
+        }
+    }
+    pairs.count = 0;
+}
+
+static void _push_pair(PhysicsFields const &physics, PairBatch &pairs, EntityID const &ent1, EntityID const &ent2) {
+    EntityID::id_type const a = ent1.id;
+    EntityID::id_type const b = ent2.id;
+    if (pair_kind[a] & pair_kind[b] & PairKind::kDormant) return;
+    uint32_t const i = pairs.count++;
+    pairs.ent1[i] = ent1;
+    pairs.ent2[i] = ent2;
+    pairs.dx[i] = physics.x[a] - physics.x[b];
+    pairs.dy[i] = physics.y[a] - physics.y[b];
+    pairs.min_dist[i] = physics.radius[a] + physics.radius[b];
+    uint32_t const kind1 = pair_kind[a] & (PairKind::kNumKinds - 1);
+    uint32_t const kind2 = pair_kind[b] & (PairKind::kNumKinds - 1);
+    pairs.interacts[i] = INTERACT_TABLE[((pair_team[a] == pair_team[b]) << 12) | (kind1 << 6) | kind2];
+    if (pairs.count == PAIR_CHUNK) _flush_pairs(pairs);
+}
+
+void tick_entity_collisions(Simulation *sim) {
+    sim->for_each<kPhysics>([](Simulation *, Entity &ent) {
+        EntityID const team = ent.get_team();
+        uint8_t kind = 0;
+        if (ent.has_component(kMob)) kind |= PairKind::kMob;
+        if (ent.has_component(kFlower)) kind |= PairKind::kFlower;
+        if (ent.has_component(kDrop)) kind |= PairKind::kDrop;
+        if (ent.has_component(kFlower) && ent.get_color() == ColorID::kRed) kind |= PairKind::kRedFlower;
+        if (ent.get_mob_id() == MobID::kTargetDummy) kind |= PairKind::kTargetDummy;
+        if (BitMath::at(ent.flags, EntityFlags::kNoFriendlyCollision)) kind |= PairKind::kNoFriendlyCollision;
+        if (entity_is_dormant(ent)) kind |= PairKind::kDormant;
+        //ids are below 2^24, see ENTITY_CAP
+        pair_team[ent.id.id] = (team.id << 8) | team.hash;
+        pair_kind[ent.id.id] = kind;
+    });
+    sim->spatial_hash.finish_inserts();
+    ThreadPool::parallel_for(COLLISION_STRIPES, [&](uint32_t stripe) {
+        PairBatch &pairs = stripes[stripe];
+        pairs.count = 0;
+        pairs.hits.clear();
+        sim->spatial_hash.collide_stripe(stripe, COLLISION_STRIPES, [&](Simulation *, EntityID const &ent1, EntityID const &ent2) {
+            _push_pair(sim->physics, pairs, ent1, ent2);
+        });
+        _flush_pairs(pairs);
+    });
+    for (PairBatch const &pairs : stripes)
+        for (uint32_t i = 0; i < pairs.hits.size(); i += 2)
+            on_collide(sim, sim->get_ent(pairs.hits[i]), sim->get_ent(pairs.hits[i + 1]));
+}
@@ -157,7 +157,7 @@ void tick_player_behavior(Simulation *sim, Entity &player) {
         Entity &camera = sim->get_ent(player.get_parent());
         camera.set_fov(BASE_FOV * (1 - buffs.extra_vision));
     }
-    player.speed_ratio *= buffs.movement_speed;
+    player.speed_ratio() *= buffs.movement_speed;
     PetalID::T unstackable_spawned[MAX_SLOT_COUNT];
     uint32_t unstackable_count = 0;
     DEBUG_ONLY(assert(player.get_loadout_count() <= MAX_SLOT_COUNT);)
@@ -250,7 +250,7 @@ void tick_player_behavior(Simulation *sim, Entity &player) {
                     }
                     wanting += delta;
                     wanting *= 0.5;
-                    petal.acceleration = wanting;
+                    petal.acceleration() = wanting;
                     game_tick_t sec_reload_ticks = petal_data.attributes.secondary_reload * TPS;
                     if (petal_data.attributes.spawns != MobID::kNumMobs &&
                         petal.secondary_reload > sec_reload_ticks) {
@@ -1,25 +1,143 @@
 #include <Server/Process.hh>
 
+#include <Server/EntityFunctions.hh>
+
 #include <Shared/Simulation.hh>
 #include <Shared/Entity.hh>
 
-void tick_entity_motion(Simulation *sim, Entity &ent) {
-    if (ent.pending_delete) return;
-    if (ent.slow_ticks > 0) {
-        ent.speed_ratio *= 0.5;
-        --ent.slow_ticks;
+#include <Helpers/Simd.hh>
+
+//the integrator works on packed copies of the physics fields, LANES entities
+//at a time, in the same op order as the per-entity code it replaced
+
+//entities are packed in chunks while their cache lines are still warm
+//arena-bound entities and the rest (petals, webs) go into separate batches
+static uint32_t const CHUNK = 256;
+static_assert(CHUNK % LANES == 0);
+
+struct MotionBatch {
+    float x[CHUNK];
+    float y[CHUNK];
+    float radius[CHUNK];
+    float vx[CHUNK];
+    float vy[CHUNK];
+    float ax[CHUNK];
+    float ay[CHUNK];
+    float cvx[CHUNK];
+    float cvy[CHUNK];
+    float friction[CHUNK];
+    float speed_ratio[CHUNK];
+    //position before the arena clamp, needed to replay both set_x calls
+    float moved_x[CHUNK];
+    float moved_y[CHUNK];
+    Entity *entities[CHUNK];
+    uint32_t count;
+};
+
+static MotionBatch clamped;
+static MotionBatch unclamped;
+
+static void _pack(PhysicsFields const &physics, MotionBatch &batch, Entity &ent) {
+    EntityID::id_type const id = ent.id.id;
+    uint32_t const i = batch.count++;
+    batch.entities[i] = &ent;
+    batch.x[i] = physics.x[id];
+    batch.y[i] = physics.y[id];
+    batch.radius[i] = physics.radius[id];
+    batch.vx[i] = physics.velocity[id].x;
+    batch.vy[i] = physics.velocity[id].y;
+    batch.ax[i] = physics.acceleration[id].x;
+    batch.ay[i] = physics.acceleration[id].y;
+    batch.cvx[i] = physics.collision_velocity[id].x;
+    batch.cvy[i] = physics.collision_velocity[id].y;
+    batch.friction[i] = physics.friction[id];
+    batch.speed_ratio[i] = physics.speed_ratio[id];
+}
+
+template<bool clamp>
+static void _integrate(MotionBatch &batch) {
+    lane_t const one = _splat(1);
+    lane_t const half = _splat(0.5);
+    lane_t const width = _splat(ARENA_WIDTH);
+    lane_t const height = _splat(ARENA_HEIGHT);
+    for (uint32_t i = 0; i < batch.count; i += LANES) {
+        lane_t vx = _mul(_load(batch.vx + i), _sub(one, _load(batch.friction + i)));
+        lane_t vy = _mul(_load(batch.vy + i), _sub(one, _load(batch.friction + i)));
+        vx = _add(vx, _mul(_load(batch.ax + i), _load(batch.speed_ratio + i)));
+        vy = _add(vy, _mul(_load(batch.ay + i), _load(batch.speed_ratio + i)));
+        lane_t cvx = _load(batch.cvx + i);
+        lane_t cvy = _load(batch.cvy + i);
+        //the old per-entity code got this order from -ffast-math
+        lane_t x = _add(_add(vx, cvx), _load(batch.x + i));
+        lane_t y = _add(_add(vy, cvy), _load(batch.y + i));
+        _store(batch.moved_x + i, x);
+        _store(batch.moved_y + i, y);
+        vx = _add(vx, _mul(cvx, half));
+        vy = _add(vy, _mul(cvy, half));
+        _store(batch.vx + i, vx);
+        _store(batch.vy + i, vy);
+        if constexpr (clamp) {
+            lane_t r = _load(batch.radius + i);
+            x = _clamp(x, r, _sub(width, r));
+            y = _clamp(y, r, _sub(height, r));
+        }
+        _store(batch.x + i, x);
+        _store(batch.y + i, y);
     }
-    ent.velocity *= (1 - ent.friction);
-    ent.velocity += (ent.acceleration * ent.speed_ratio);
-    ent.set_x(ent.get_x() + ent.velocity.x + ent.collision_velocity.x);
-    ent.set_y(ent.get_y() + ent.velocity.y + ent.collision_velocity.y);
-    ent.collision_velocity *= 0.5;
-    ent.velocity += ent.collision_velocity;
-    if (!ent.has_component(kPetal) && !ent.has_component(kWeb) && !ent.has_component(kPoisonWeb)) {
-        ent.set_x(fclamp(ent.get_x(), ent.get_radius(), ARENA_WIDTH - ent.get_radius()));
-        ent.set_y(fclamp(ent.get_y(), ent.get_radius(), ARENA_HEIGHT - ent.get_radius()));
+}
+
+template<bool clamp>
+static void _flush(PhysicsFields &physics, MotionBatch &batch) {
+    uint32_t const count = batch.count;
+    //zero the tail of the last group of lanes
+    for (; batch.count % LANES != 0; ++batch.count) {
+        uint32_t const i = batch.count;
+        batch.x[i] = batch.y[i] = batch.radius[i] = 0;
+        batch.vx[i] = batch.vy[i] = batch.ax[i] = batch.ay[i] = 0;
+        batch.cvx[i] = batch.cvy[i] = batch.friction[i] = batch.speed_ratio[i] = 0;
     }
+    _integrate<clamp>(batch);
+    for (uint32_t i = 0; i < count; ++i) {
+        Entity &ent = *batch.entities[i];
+        EntityID::id_type const id = ent.id.id;
+        physics.velocity[id].set(batch.vx[i], batch.vy[i]);
+        physics.collision_velocity[id].set(0,0);
+        physics.speed_ratio[id] = 1;
+        //same set_x/set_y sequence as before, so the dirty bits match too
+        ent.set_x(batch.moved_x[i]);
+        ent.set_y(batch.moved_y[i]);
+        if constexpr (clamp) {
+            ent.set_x(batch.x[i]);
+            ent.set_y(batch.y[i]);
+        }
+    }
+    batch.count = 0;
+}
+
+void tick_entity_motion(Simulation *sim) {
+    PhysicsFields &physics = sim->physics;
+    clamped.count = unclamped.count = 0;
+    sim->for_each<kPhysics>([&](Simulation *, Entity &ent) {
+        if (ent.slow_ticks > 0) {
+            ent.speed_ratio() *= 0.5;
+            --ent.slow_ticks;
+        }
+        if (entity_is_dormant(ent)) {
+            //left where it is, only the resets the integrator would have done
+            EntityID::id_type const id = ent.id.id;
+            physics.velocity[id].set(0,0);
+            physics.speed_ratio[id] = 1;
+            return;
+        }
+        if (!ent.has_component(kPetal) && !ent.has_component(kWeb) && !ent.has_component(kPoisonWeb)) {
+            _pack(physics, clamped, ent);
+            if (clamped.count == CHUNK) _flush<true>(physics, clamped);
+        } else {
+            _pack(physics, unclamped, ent);
+            if (unclamped.count == CHUNK) _flush<false>(physics, unclamped);
+        }
+    });
+    _flush<true>(physics, clamped);
+    _flush<false>(physics, unclamped);
     //ent.acceleration.set(0,0);
-    ent.collision_velocity.set(0,0);
-    ent.speed_ratio = 1;
-}
\ No newline at end of file
+}
@@ -31,19 +31,19 @@ void tick_petal_behavior(Simulation *sim, Entity &petal) {
             case PetalID::kDandelion:
             case PetalID::kBullet:
             case PetalID::kDestroyerBullet:{
-                petal.acceleration.unit_normal(petal.get_angle()).set_magnitude(4 * PLAYER_ACCELERATION);
+                petal.acceleration().unit_normal(petal.get_angle()).set_magnitude(4 * PLAYER_ACCELERATION);
                 break;
             }
             case PetalID::kMoon: {
-                petal.acceleration.unit_normal(petal.get_angle()).set_magnitude(2 * PLAYER_ACCELERATION);
+                petal.acceleration().unit_normal(petal.get_angle()).set_magnitude(2 * PLAYER_ACCELERATION);
                 break;
             }
             case PetalID::kDrone: {
-                petal.acceleration.unit_normal(petal.get_angle()).set_magnitude(2.5 * PLAYER_ACCELERATION);
+                petal.acceleration().unit_normal(petal.get_angle()).set_magnitude(2.5 * PLAYER_ACCELERATION);
                 break;
             }
             default:
-                petal.acceleration.set(0,0);
+                petal.acceleration().set(0,0);
                 break;
         }
     }
@@ -58,7 +58,7 @@ void tick_petal_behavior(Simulation *sim, Entity &petal) {
                     return;
                 }
                 delta.set_magnitude(PLAYER_ACCELERATION * 4);
-                petal.acceleration = delta;
+                petal.acceleration() = delta;
             }
             switch (petal.get_petal_id()) {
                 case PetalID::kMissile:
@@ -66,7 +66,7 @@ void tick_petal_behavior(Simulation *sim, Entity &petal) {
                 case PetalID::kBullet:
                 case PetalID::kDestroyerBullet:
                     if (BitMath::at(player.input, InputFlags::kAttacking)) {
-                        petal.acceleration.unit_normal(petal.get_angle()).set_magnitude(4 * PLAYER_ACCELERATION);
+                        petal.acceleration().unit_normal(petal.get_angle()).set_magnitude(4 * PLAYER_ACCELERATION);
                         entity_set_despawn_tick(petal, 3 * TPS);
                     }
                     break;
@@ -75,10 +75,10 @@ void tick_petal_behavior(Simulation *sim, Entity &petal) {
                 case PetalID::kWeb: {
                     if (BitMath::at(player.input, InputFlags::kAttacking)) {
                         Vector delta(petal.get_x() - player.get_x(), petal.get_y() - player.get_y());
-                        petal.friction = DEFAULT_FRICTION;
+                        petal.friction() = DEFAULT_FRICTION;
                         float angle = delta.angle();
                         if (petal.get_petal_id() == PetalID::kTriweb) angle += frand() - 0.5;
-                        petal.acceleration.unit_normal(angle).set_magnitude(30 * PLAYER_ACCELERATION);
+                        petal.acceleration().unit_normal(angle).set_magnitude(30 * PLAYER_ACCELERATION);
                         entity_set_despawn_tick(petal, 0.6 * TPS);
                     } else if (BitMath::at(player.input, InputFlags::kDefending))
                         entity_set_despawn_tick(petal, 0.6 * TPS);
@@ -88,13 +88,13 @@ void tick_petal_behavior(Simulation *sim, Entity &petal) {
                     if (BitMath::at(player.input, InputFlags::kDefending)) {
                         Vector v(player.get_x() - petal.get_x(), player.get_y() - petal.get_y());
                         v.set_magnitude(PLAYER_ACCELERATION * 20);
-                        player.velocity += v;
+                        player.velocity() += v;
                         sim->request_delete(petal.id);
                     }
                     break;
                 case PetalID::kPollen:
                     if (BitMath::at(player.input, InputFlags::kAttacking) || BitMath::at(player.input, InputFlags::kDefending)) {
-                        petal.friction = DEFAULT_FRICTION;
+                        petal.friction() = DEFAULT_FRICTION;
                         entity_set_despawn_tick(petal, 4.0 * TPS);
                     }
                     break;
@@ -103,20 +103,20 @@ void tick_petal_behavior(Simulation *sim, Entity &petal) {
                 case PetalID::kPoisonPeas2:
                     if (BitMath::at(player.input, InputFlags::kAttacking)) {
                         Vector delta(petal.get_x() - player.get_x(), petal.get_y() - player.get_y());
-                        petal.friction = DEFAULT_FRICTION / 10;
-                        petal.acceleration.unit_normal(delta.angle()).set_magnitude(10 * PLAYER_ACCELERATION);
+                        petal.friction() = DEFAULT_FRICTION / 10;
+                        petal.acceleration().unit_normal(delta.angle()).set_magnitude(10 * PLAYER_ACCELERATION);
                         entity_set_despawn_tick(petal, TPS);
                     }
                     break;
                 case PetalID::kMoon: {
                     if (BitMath::at(player.input, InputFlags::kAttacking)) {
-                        petal.acceleration.unit_normal(petal.get_angle()).set_magnitude(4 * PLAYER_ACCELERATION);
+                        petal.acceleration().unit_normal(petal.get_angle()).set_magnitude(4 * PLAYER_ACCELERATION);
                         entity_set_despawn_tick(petal, 10 * TPS);
                     }
                     break;
                 }
                 case PetalID::kDrone: {
-                    petal.acceleration.unit_normal(petal.get_angle()).set_magnitude(4 * PLAYER_ACCELERATION);
+                    petal.acceleration().unit_normal(petal.get_angle()).set_magnitude(4 * PLAYER_ACCELERATION);
                     entity_set_despawn_tick(petal, 15 * TPS);
                 }
                 default:
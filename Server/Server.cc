@@ -2,6 +2,7 @@
 
 #include <Server/Game.hh>
 #include <Server/Client.hh>
+#include <Server/ThreadPool.hh>
 
 #include <Shared/Binary.hh>
 
@@ -9,7 +10,7 @@
 #include <iostream>
 
 namespace Server {
-    uint8_t OUTGOING_PACKET[MAX_PACKET_LEN] = {0};
+    std::vector<uint8_t> OUTGOING_PACKET;
     GameInstance game;
 }
 
@@ -25,6 +26,7 @@ void Server::tick() {
 }
 
 void Server::init() {
+    ThreadPool::init(0);
     Server::game.init();
     Server::run();
 }
@@ -3,9 +3,12 @@
 #include <Server/Game.hh>
 
 #include <set>
+#include <vector>
 
 class Client;
 
+//starting size of the client's receive buffer, larger packets make it grow
+//and are counted separately by TickProfiler::packet_report
 size_t const MAX_PACKET_LEN = 64 * 1024;
 
 #ifdef WASM_SERVER
@@ -19,7 +22,8 @@ typedef uWS::App WebSocketServer;
 #endif
 
 namespace Server {
-    extern uint8_t OUTGOING_PACKET[MAX_PACKET_LEN];
+    //reused by every packet built on the game thread outside replication
+    extern std::vector<uint8_t> OUTGOING_PACKET;
     extern GameInstance game;
     extern WebSocketServer server;
     extern void init();
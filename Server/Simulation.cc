@@ -6,6 +6,7 @@
 #include <Server/Server.hh>
 #include <Server/Spawn.hh>
 #include <Server/SpatialHash.hh>
+#include <Server/TickProfiler.hh>
 #include "AsymmetricBattle.hh"
 #include <Shared/Map.hh>
 
@@ -31,7 +32,7 @@ static void calculate_leaderboard(Simulation *sim) {
 }
 
 void Simulation::on_tick() {
-    spatial_hash.refresh(ARENA_WIDTH, ARENA_HEIGHT);
+    TickProfiler::lap(TickPhase::kActiveSet);
     if (frand() < 1.0f / TPS) {
         for (uint32_t i = 0; i < 10; ++i) {
             Vector v;
@@ -39,25 +40,42 @@ void Simulation::on_tick() {
                 Map::spawn_random_mob(this, v.x, v.y);
         }
     }
+    TickProfiler::lap(TickPhase::kSpawning);
+    spatial_hash.refresh(ARENA_WIDTH, ARENA_HEIGHT);
     for_each_entity([](Simulation *sim, Entity &ent) {
         if (ent.has_component(kPhysics))
             sim->spatial_hash.insert(ent);
         if (BitMath::at(ent.flags, EntityFlags::kHasCulling))
             BitMath::set(ent.flags, EntityFlags::kIsCulled);
     });
+    TickProfiler::lap(TickPhase::kBroadphase);
     for_each<kCamera>(tick_culling_behavior);
+    TickProfiler::lap(TickPhase::kCulling);
     for_each<kFlower>(tick_player_behavior);
-    for_each<kMob>(tick_ai_behavior);
+    TickProfiler::lap(TickPhase::kPlayer);
+    targets.build(this);
+    tick_ai_think(this);
+    tick_ai_behavior(this);
+    TickProfiler::lap(TickPhase::kAi);
     for_each<kPetal>(tick_petal_behavior);
+    TickProfiler::lap(TickPhase::kPetal);
     for_each<kHealth>(tick_health_behavior);
-    spatial_hash.collide(on_collide);
+    TickProfiler::lap(TickPhase::kHealth);
+    tick_entity_collisions(this);
+    TickProfiler::lap(TickPhase::kCollision);
     //tick_curse_behavior(this);
-    for_each<kPhysics>(tick_entity_motion);
+    tick_entity_motion(this);
+    TickProfiler::lap(TickPhase::kMotion);
     for_each<kSegmented>(tick_segment_behavior);
+    TickProfiler::lap(TickPhase::kSegment);
     for_each<kCamera>(tick_camera_behavior);
+    TickProfiler::lap(TickPhase::kCamera);
     for_each<kScore>(tick_score_behavior);
+    TickProfiler::lap(TickPhase::kScore);
     for_each_entity(entity_clear_references);
+    TickProfiler::lap(TickPhase::kReferences);
     calculate_leaderboard(this);
+    TickProfiler::lap(TickPhase::kLeaderboard);
 }
 
 void Simulation::post_tick() {
@@ -3,8 +3,10 @@
 #include <Shared/Entity.hh>
 #include <Shared/StaticData.hh>
 
+#include <Helpers/Array.hh>
+
+#include <array>
 #include <cstdint>
-#include <functional>
 #include <vector>
 
 class Simulation;
@@ -13,16 +15,75 @@ class Entity;
 static const uint32_t GRID_SIZE = 100 * 2;
 static const uint32_t MAX_GRID_X = div_round_up(ARENA_WIDTH, GRID_SIZE);
 static const uint32_t MAX_GRID_Y = div_round_up(ARENA_HEIGHT, GRID_SIZE);
+//the uniform backend puts entities with radius > GRID_SIZE / 2 in a second, coarser grid
+static const uint32_t COARSE_GRID_SIZE = GRID_SIZE * 8;
+static const uint32_t MAX_COARSE_X = div_round_up(ARENA_WIDTH, COARSE_GRID_SIZE);
+static const uint32_t MAX_COARSE_Y = div_round_up(ARENA_HEIGHT, COARSE_GRID_SIZE);
 
 class SpatialHash {
     Simulation *simulation;
+#ifdef SORTED_SPATIAL_HASH
+    //cell (x, y) owns sorted[cell_start[x * MAX_GRID_Y + y]] up to the next cell's start
+    std::array<uint32_t, MAX_GRID_X * MAX_GRID_Y + 1> cell_start;
+    std::array<EntityID, ENTITY_CAP> sorted;
+    //insert() only appends here, the counting sort runs on the first collide/query
+    StaticArray<EntityID, ENTITY_CAP> pending;
+    StaticArray<uint16_t, ENTITY_CAP> pending_cells;
+    uint8_t is_sorted;
+    void sort();
+#else
     std::vector<EntityID> cells[MAX_GRID_X][MAX_GRID_Y];
+#ifdef GENERAL_SPATIAL_HASH
+    //first cell each entity was inserted into, a pair only collides
+    //in the first cell both of them are in
+    std::array<uint8_t, ENTITY_CAP> first_x;
+    std::array<uint8_t, ENTITY_CAP> first_y;
+    //query() skips entities already stamped with the current generation
+    std::array<uint32_t, ENTITY_CAP> query_stamp;
+    uint32_t query_generation;
+    uint32_t next_query_generation();
+#else
+    //cells persist between ticks and stay sorted by id, insert() only
+    //moves an entity when its cell (x * MAX_GRID_Y + y) changes
+    //coarse cells are numbered after the fine ones
+    std::array<uint16_t, ENTITY_CAP> entity_cell;
+    //one bit per non-empty fine cell, collide() skips everything else
+    std::array<uint64_t, div_round_up(MAX_GRID_X * MAX_GRID_Y, 64)> occupied;
+    std::vector<EntityID> coarse_cells[MAX_COARSE_X][MAX_COARSE_Y];
+    uint32_t coarse_count;
+    std::vector<EntityID> &cell_at(uint32_t);
+#endif
+#endif
     uint32_t width;
     uint32_t height;
 public:
     SpatialHash(Simulation *);
+    //starts the per-tick insert pass
     void refresh(uint32_t, uint32_t);
     void insert(Entity const &);
-    void collide(std::function<void(Simulation *, Entity &, Entity &)>);
-    void query(float, float, float, float, std::function<void(Simulation *, Entity &)>);
-};
\ No newline at end of file
+    //called when an entity is deleted
+    void remove(EntityID const &);
+    //drops every entity, for Simulation::reset
+    void clear();
+    //finishes whatever insert() left for later, collide_stripe needs it done
+    void finish_inserts();
+    //defined by the backend header, see Shared/Simulation.hh
+    //on_collide(Simulation *, EntityID const &, EntityID const &)
+    template<typename F>
+    void collide(F &&);
+    //stripe <i> of <n> column stripes of collide(), running 0..n-1 in order
+    //visits the same pairs in the same order. stripes only read the hash,
+    //so different ones can run on different threads
+    template<typename F>
+    void collide_stripe(uint32_t, uint32_t, F &&);
+    //cb(Simulation *, Entity &)
+    template<typename F>
+    void query(float, float, float, float, F &&);
+    //whether query() can run on several threads at once, the canonical
+    //backend dedupes through stamps it shares between queries
+#ifdef GENERAL_SPATIAL_HASH
+    static bool const PARALLEL_QUERY = false;
+#else
+    static bool const PARALLEL_QUERY = true;
+#endif
+};
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <Server/SpatialHash.hh>
+
+#include <Shared/Simulation.hh>
+
+#include <algorithm>
+
+template<typename F>
+void SpatialHash::collide(F &&on_collide) {
+    collide_stripe(0, 1, on_collide);
+}
+
+template<typename F>
+void SpatialHash::collide_stripe(uint32_t stripe, uint32_t stripes, F &&on_collide) {
+    for (uint32_t x = MAX_GRID_X * stripe / stripes; x < MAX_GRID_X * (stripe + 1) / stripes; ++x) {
+        for (uint32_t y = 0; y < MAX_GRID_Y; ++y) {
+            std::vector<EntityID> const &cell = cells[x][y];
+            for (uint32_t i = 0; i < cell.size(); ++i) {
+                EntityID::id_type const a = cell[i].id;
+                for (uint32_t j = i + 1; j < cell.size(); ++j) {
+                    //the first shared cell in this x-major walk is the
+                    //top left corner of the overlap of both cell ranges
+                    EntityID::id_type const b = cell[j].id;
+                    if (std::max(first_x[a], first_x[b]) != x) continue;
+                    if (std::max(first_y[a], first_y[b]) != y) continue;
+                    on_collide(simulation, cell[i], cell[j]);
+                }
+            }
+        }
+    }
+}
+
+template<typename F>
+void SpatialHash::query(float x, float y, float w, float h, F &&cb) {
+    PhysicsFields const &physics = simulation->physics;
+    uint32_t const generation = next_query_generation();
+    uint32_t sx = fclamp(x - w, 0, ARENA_WIDTH - 1) / GRID_SIZE;
+    uint32_t sy = fclamp(y - h, 0, ARENA_HEIGHT - 1) / GRID_SIZE;
+    uint32_t ex = fclamp(x + w, 0, ARENA_WIDTH - 1) / GRID_SIZE;
+    uint32_t ey = fclamp(y + h, 0, ARENA_HEIGHT - 1) / GRID_SIZE;
+    for (uint32_t _x = sx; _x <= ex; ++_x) {
+        for (uint32_t _y = sy; _y <= ey; ++_y) {
+            std::vector<EntityID> const &cell = cells[_x][_y];
+            for (uint32_t i = 0; i < cell.size(); ++i) {
+                EntityID::id_type const id = cell[i].id;
+                if (physics.x[id] + physics.radius[id] < x - w) continue;
+                if (physics.x[id] - physics.radius[id] > x + w) continue;
+                if (physics.y[id] + physics.radius[id] < y - h) continue;
+                if (physics.y[id] - physics.radius[id] > y + h) continue;
+                if (query_stamp[id] == generation) continue;
+                query_stamp[id] = generation;
+                cb(simulation, simulation->get_ent(cell[i]));
+            }
+        }
+    }
+}
@@ -0,0 +1,56 @@
+#include <Server/SpatialHash.hh>
+
+#include <Shared/Simulation.hh>
+#include <Shared/Entity.hh>
+
+static_assert(MAX_GRID_X * MAX_GRID_Y <= 65536);
+
+SpatialHash::SpatialHash(Simulation *sim) : simulation(sim), is_sorted(1), width(1), height(1) {
+    cell_start.fill(0);
+}
+
+void SpatialHash::refresh(uint32_t _width, uint32_t _height) {
+    DEBUG_ONLY(assert(_width <= ARENA_WIDTH && _height <= ARENA_HEIGHT));
+    width = div_round_up(_width, GRID_SIZE);
+    height = div_round_up(_height, GRID_SIZE);
+    clear();
+}
+
+void SpatialHash::clear() {
+    pending.clear();
+    pending_cells.clear();
+    is_sorted = 0;
+}
+
+//every entity is inserted again after the next refresh()
+void SpatialHash::remove(EntityID const &) {}
+
+void SpatialHash::finish_inserts() {
+    if (!is_sorted) sort();
+}
+
+void SpatialHash::insert(Entity const &ent) {
+    DEBUG_ONLY(assert(ent.has_component(kPhysics));)
+    //same single-cell insert as SpatialHashUniform, so the same radius limit applies
+    DEBUG_ONLY(assert(ent.get_radius() <= GRID_SIZE / 2);)
+    uint32_t x = fclamp(ent.get_x(), 0, ARENA_WIDTH - 1) / GRID_SIZE;
+    uint32_t y = fclamp(ent.get_y(), 0, ARENA_HEIGHT - 1) / GRID_SIZE;
+    pending.push(ent.id);
+    pending_cells.push(x * MAX_GRID_Y + y);
+    is_sorted = 0;
+}
+
+void SpatialHash::sort() {
+    uint32_t const cell_count = MAX_GRID_X * MAX_GRID_Y;
+    cell_start.fill(0);
+    for (uint16_t cell : pending_cells)
+        ++cell_start[cell];
+    for (uint32_t i = 1; i < cell_count; ++i)
+        cell_start[i] += cell_start[i - 1];
+    //every cell_start now holds the end of its cell, filling backwards moves it
+    //to the start and keeps insertion order inside each cell
+    for (uint32_t i = pending.size(); i > 0; --i)
+        sorted[--cell_start[pending_cells[i - 1]]] = pending[i - 1];
+    cell_start[cell_count] = pending.size();
+    is_sorted = 1;
+}
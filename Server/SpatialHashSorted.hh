@@ -0,0 +1,60 @@
+#pragma once
+
+#include <Server/SpatialHash.hh>
+
+#include <Shared/Simulation.hh>
+
+//same cells and pair order as SpatialHashUniform, but every cell is a range
+//of one flat array instead of its own std::vector
+template<typename F>
+void SpatialHash::collide(F &&on_collide) {
+    finish_inserts();
+    collide_stripe(0, 1, on_collide);
+}
+
+template<typename F>
+void SpatialHash::collide_stripe(uint32_t stripe, uint32_t stripes, F &&on_collide) {
+    DEBUG_ONLY(assert(is_sorted);)
+    auto collide_cell = [&](EntityID const &ent, uint32_t cell) {
+        for (uint32_t j = cell_start[cell]; j < cell_start[cell + 1]; ++j)
+            on_collide(simulation, ent, sorted[j]);
+    };
+    for (uint32_t x = MAX_GRID_X * stripe / stripes; x < MAX_GRID_X * (stripe + 1) / stripes; ++x) {
+        for (uint32_t y = 0; y < MAX_GRID_Y; ++y) {
+            uint32_t const cell = x * MAX_GRID_Y + y;
+            uint32_t const end = cell_start[cell + 1];
+            for (uint32_t i = cell_start[cell]; i < end; ++i) {
+                EntityID const &ent = sorted[i];
+                for (uint32_t j = i + 1; j < end; ++j) on_collide(simulation, ent, sorted[j]);
+                if (x < MAX_GRID_X - 1) {
+                    collide_cell(ent, cell + MAX_GRID_Y);
+                    if (y > 0) collide_cell(ent, cell + MAX_GRID_Y - 1);
+                    if (y < MAX_GRID_Y - 1) collide_cell(ent, cell + MAX_GRID_Y + 1);
+                }
+                if (y < MAX_GRID_Y - 1) collide_cell(ent, cell + 1);
+            }
+        }
+    }
+}
+
+template<typename F>
+void SpatialHash::query(float x, float y, float w, float h, F &&cb) {
+    if (!is_sorted) sort();
+    PhysicsFields const &physics = simulation->physics;
+    uint32_t sx = fclamp(x - w - GRID_SIZE / 2, 0, ARENA_WIDTH - 1) / GRID_SIZE;
+    uint32_t sy = fclamp(y - h - GRID_SIZE / 2, 0, ARENA_HEIGHT - 1) / GRID_SIZE;
+    uint32_t ex = fclamp(x + w + GRID_SIZE / 2, 0, ARENA_WIDTH - 1) / GRID_SIZE;
+    uint32_t ey = fclamp(y + h + GRID_SIZE / 2, 0, ARENA_HEIGHT - 1) / GRID_SIZE;
+    for (uint32_t _x = sx; _x <= ex; ++_x) {
+        //cells sy..ey of a column are adjacent, so walk them as one range
+        uint32_t const end = cell_start[_x * MAX_GRID_Y + ey + 1];
+        for (uint32_t i = cell_start[_x * MAX_GRID_Y + sy]; i < end; ++i) {
+            EntityID::id_type const id = sorted[i].id;
+            if (physics.x[id] + physics.radius[id] < x - w) continue;
+            if (physics.x[id] - physics.radius[id] > x + w) continue;
+            if (physics.y[id] + physics.radius[id] < y - h) continue;
+            if (physics.y[id] - physics.radius[id] > y + h) continue;
+            cb(simulation, simulation->get_ent(sorted[i]));
+        }
+    }
+}
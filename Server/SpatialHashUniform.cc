@@ -3,71 +3,79 @@
 #include <Shared/Simulation.hh>
 #include <Shared/Entity.hh>
 
-SpatialHash::SpatialHash(Simulation *sim) : simulation(sim), width(1), height(1) {}
+#include <Helpers/Bits.hh>
+
+#include <algorithm>
+#include <bit>
+
+static uint32_t const FINE_CELLS = MAX_GRID_X * MAX_GRID_Y;
+static uint16_t const NO_CELL = 0xffff;
+static_assert(FINE_CELLS + MAX_COARSE_X * MAX_COARSE_Y < NO_CELL);
+
+SpatialHash::SpatialHash(Simulation *sim) : simulation(sim), coarse_count(0), width(1), height(1) {
+    entity_cell.fill(NO_CELL);
+    occupied.fill(0);
+}
+
+std::vector<EntityID> &SpatialHash::cell_at(uint32_t cell) {
+    if (cell < FINE_CELLS) return cells[cell / MAX_GRID_Y][cell % MAX_GRID_Y];
+    cell -= FINE_CELLS;
+    return coarse_cells[cell / MAX_COARSE_Y][cell % MAX_COARSE_Y];
+}
 
 void SpatialHash::refresh(uint32_t _width, uint32_t _height) {
     DEBUG_ONLY(assert(_width <= ARENA_WIDTH && _height <= ARENA_HEIGHT));
     width = div_round_up(_width, GRID_SIZE);
     height = div_round_up(_height, GRID_SIZE);
-    for (uint32_t x = 0; x < MAX_GRID_X; ++x)
-        for (uint32_t y = 0; y < MAX_GRID_Y; ++y)
-            cells[x][y].clear();
 }
 
-void SpatialHash::insert(Entity const &ent) {
-    DEBUG_ONLY(assert(ent.has_component(kPhysics));)
-    //for the uniform grid to work, the max ent radius is GRID_SIZE/2
-    //if larger entities are needed, either increase the GRID_SIZE
-    //or use SpatialHashCanonical
-    DEBUG_ONLY(assert(ent.get_radius() <= GRID_SIZE / 2);)
-    uint32_t x = fclamp(ent.get_x(), 0, ARENA_WIDTH - 1) / GRID_SIZE;
-    uint32_t y = fclamp(ent.get_y(), 0, ARENA_HEIGHT - 1) / GRID_SIZE;
-    cells[x][y].push_back(ent.id);
-}
-
-void SpatialHash::collide(std::function<void(Simulation *, Entity &, Entity &)> on_collide) {
-    for (uint32_t x = 0; x < MAX_GRID_X; ++x) {
-        for (uint32_t y = 0; y < MAX_GRID_Y; ++y) {
-            std::vector<EntityID> &cell = cells[x][y];
-            for (uint32_t i = 0; i < cell.size(); ++i) {
-                for (uint32_t j = i + 1; j < cell.size(); ++j) on_collide(simulation, simulation->get_ent(cell[i]), simulation->get_ent(cell[j]));
-                if (x < MAX_GRID_X - 1) {
-                    std::vector<EntityID> &cell2 = cells[x+1][y];
-                    for (uint32_t j = 0; j < cell2.size(); ++j) on_collide(simulation, simulation->get_ent(cell[i]), simulation->get_ent(cell2[j]));
-                    if (y > 0) {
-                        std::vector<EntityID> &cell2 = cells[x+1][y-1];
-                        for (uint32_t j = 0; j < cell2.size(); ++j) on_collide(simulation, simulation->get_ent(cell[i]), simulation->get_ent(cell2[j]));
-                    }
-                    if (y < MAX_GRID_Y - 1) {
-                        std::vector<EntityID> &cell2 = cells[x+1][y+1];
-                        for (uint32_t j = 0; j < cell2.size(); ++j) on_collide(simulation, simulation->get_ent(cell[i]), simulation->get_ent(cell2[j]));
-                    }
-                }
-                if (y < MAX_GRID_Y - 1) {
-                    std::vector<EntityID> &cell2 = cells[x][y+1];
-                    for (uint32_t j = 0; j < cell2.size(); ++j) on_collide(simulation, simulation->get_ent(cell[i]), simulation->get_ent(cell2[j]));
-                }
-            }
+void SpatialHash::clear() {
+    for (uint32_t w = 0; w < occupied.size(); ++w) {
+        for (uint64_t word = occupied[w]; word != 0; word &= word - 1) {
+            uint32_t const cell = w * 64 + std::countr_zero(word);
+            cells[cell / MAX_GRID_Y][cell % MAX_GRID_Y].clear();
         }
     }
+    for (uint32_t x = 0; x < MAX_COARSE_X; ++x)
+        for (uint32_t y = 0; y < MAX_COARSE_Y; ++y)
+            coarse_cells[x][y].clear();
+    occupied.fill(0);
+    entity_cell.fill(NO_CELL);
+    coarse_count = 0;
 }
 
-void SpatialHash::query(float x, float y, float w, float h, std::function<void(Simulation *, Entity &)> cb) {
-    uint32_t sx = fclamp(x - w - GRID_SIZE / 2, 0, ARENA_WIDTH - 1) / GRID_SIZE;
-    uint32_t sy = fclamp(y - h - GRID_SIZE / 2, 0, ARENA_HEIGHT - 1) / GRID_SIZE;
-    uint32_t ex = fclamp(x + w + GRID_SIZE / 2, 0, ARENA_WIDTH - 1) / GRID_SIZE;
-    uint32_t ey = fclamp(y + h + GRID_SIZE / 2, 0, ARENA_HEIGHT - 1) / GRID_SIZE;
-    for (uint32_t _x = sx; _x <= ex; ++_x) {
-        for (uint32_t _y = sy; _y <= ey; ++_y) {
-            std::vector<EntityID> &cell = cells[_x][_y];
-            for (uint32_t i = 0; i < cell.size(); ++i) {
-                Entity &ent = simulation->get_ent(cell[i]);
-                if (ent.get_x() + ent.get_radius() < x - w) continue;
-                if (ent.get_x() - ent.get_radius() > x + w) continue;
-                if (ent.get_y() + ent.get_radius() < y - h) continue;
-                if (ent.get_y() - ent.get_radius() > y + h) continue;
-                cb(simulation, ent);
-            }
-        }
-    }
+void SpatialHash::finish_inserts() {}
+
+void SpatialHash::remove(EntityID const &id) {
+    uint16_t const cell = entity_cell[id.id];
+    if (cell == NO_CELL) return;
+    std::vector<EntityID> &vec = cell_at(cell);
+    vec.erase(std::find_if(vec.begin(), vec.end(), [&](EntityID const &other) { return other.id == id.id; }));
+    if (cell >= FINE_CELLS) --coarse_count;
+    else if (vec.empty()) BitMath::unset_arr(occupied.data(), cell);
+    entity_cell[id.id] = NO_CELL;
+}
+
+void SpatialHash::insert(Entity const &ent) {
+    DEBUG_ONLY(assert(ent.has_component(kPhysics));)
+    //entities up to GRID_SIZE/2 go in the fine grid, anything bigger in the
+    //coarse one, which is only walked when it is not empty
+    //if even larger entities are needed, increase COARSE_GRID_SIZE
+    //or use SpatialHashCanonical
+    DEBUG_ONLY(assert(ent.get_radius() <= COARSE_GRID_SIZE / 2);)
+    uint8_t const coarse = ent.get_radius() > GRID_SIZE / 2;
+    uint32_t const size = coarse ? COARSE_GRID_SIZE : GRID_SIZE;
+    uint32_t x = fclamp(ent.get_x(), 0, ARENA_WIDTH - 1) / size;
+    uint32_t y = fclamp(ent.get_y(), 0, ARENA_HEIGHT - 1) / size;
+    uint16_t const cell = coarse ? FINE_CELLS + x * MAX_COARSE_Y + y : x * MAX_GRID_Y + y;
+    if (entity_cell[ent.id.id] == cell) return;
+    remove(ent.id);
+    //sorted by id, the order a full rebuild from for_each_entity would give
+    std::vector<EntityID> &vec = cell_at(cell);
+    vec.insert(std::lower_bound(vec.begin(), vec.end(), ent.id, [](EntityID const &a, EntityID const &b) {
+        return a.id < b.id;
+    }), ent.id);
+    if (coarse) ++coarse_count;
+    else BitMath::set_arr(occupied.data(), cell);
+    entity_cell[ent.id.id] = cell;
 }
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <Server/SpatialHash.hh>
+
+#include <Shared/Simulation.hh>
+
+#include <bit>
+
+//pairs <x, y> with itself and the cells after it, so every neighbouring pair is seen once
+template<uint32_t MAX_X, uint32_t MAX_Y, typename F>
+void _collide_cell(Simulation *simulation, std::vector<EntityID> (&cells)[MAX_X][MAX_Y], uint32_t x, uint32_t y, F &on_collide) {
+    std::vector<EntityID> &cell = cells[x][y];
+    for (uint32_t i = 0; i < cell.size(); ++i) {
+        for (uint32_t j = i + 1; j < cell.size(); ++j) on_collide(simulation, cell[i], cell[j]);
+        if (x < MAX_X - 1) {
+            std::vector<EntityID> &cell2 = cells[x+1][y];
+            for (uint32_t j = 0; j < cell2.size(); ++j) on_collide(simulation, cell[i], cell2[j]);
+            if (y > 0) {
+                std::vector<EntityID> &cell2 = cells[x+1][y-1];
+                for (uint32_t j = 0; j < cell2.size(); ++j) on_collide(simulation, cell[i], cell2[j]);
+            }
+            if (y < MAX_Y - 1) {
+                std::vector<EntityID> &cell2 = cells[x+1][y+1];
+                for (uint32_t j = 0; j < cell2.size(); ++j) on_collide(simulation, cell[i], cell2[j]);
+            }
+        }
+        if (y < MAX_Y - 1) {
+            std::vector<EntityID> &cell2 = cells[x][y+1];
+            for (uint32_t j = 0; j < cell2.size(); ++j) on_collide(simulation, cell[i], cell2[j]);
+        }
+    }
+}
+
+template<typename F>
+void SpatialHash::collide(F &&on_collide) {
+    collide_stripe(0, 1, on_collide);
+}
+
+template<typename F>
+void SpatialHash::collide_stripe(uint32_t stripe, uint32_t stripes, F &&on_collide) {
+    //occupied cells of the stripe's columns in x-major order, same as walking them all
+    uint32_t const begin = MAX_GRID_X * stripe / stripes * MAX_GRID_Y;
+    uint32_t const end = MAX_GRID_X * (stripe + 1) / stripes * MAX_GRID_Y;
+    for (uint32_t w = begin / 64; w < div_round_up(end, 64); ++w) {
+        uint64_t word = occupied[w];
+        if (w * 64 < begin) word &= ~0ull << (begin - w * 64);
+        if (end < w * 64 + 64) word &= (1ull << (end - w * 64)) - 1;
+        for (; word != 0; word &= word - 1) {
+            uint32_t const cell = w * 64 + std::countr_zero(word);
+            _collide_cell(simulation, cells, cell / MAX_GRID_Y, cell % MAX_GRID_Y, on_collide);
+        }
+    }
+    //the coarse pass comes after every fine cell, so it belongs to the last stripe
+    if (stripe != stripes - 1 || coarse_count == 0) return;
+    PhysicsFields const &physics = simulation->physics;
+    for (uint32_t x = 0; x < MAX_COARSE_X; ++x) {
+        for (uint32_t y = 0; y < MAX_COARSE_Y; ++y) {
+            _collide_cell(simulation, coarse_cells, x, y, on_collide);
+            //every fine entity the large one can reach, fine radii are at most GRID_SIZE / 2
+            for (EntityID const &large_id : coarse_cells[x][y]) {
+                float const reach = physics.radius[large_id.id] + GRID_SIZE / 2;
+                float const lx = physics.x[large_id.id];
+                float const ly = physics.y[large_id.id];
+                uint32_t sx = fclamp(lx - reach, 0, ARENA_WIDTH - 1) / GRID_SIZE;
+                uint32_t sy = fclamp(ly - reach, 0, ARENA_HEIGHT - 1) / GRID_SIZE;
+                uint32_t ex = fclamp(lx + reach, 0, ARENA_WIDTH - 1) / GRID_SIZE;
+                uint32_t ey = fclamp(ly + reach, 0, ARENA_HEIGHT - 1) / GRID_SIZE;
+                for (uint32_t _x = sx; _x <= ex; ++_x)
+                    for (uint32_t _y = sy; _y <= ey; ++_y)
+                        for (EntityID const &small_id : cells[_x][_y])
+                            on_collide(simulation, large_id, small_id);
+            }
+        }
+    }
+}
+
+template<typename F>
+void SpatialHash::query(float x, float y, float w, float h, F &&cb) {
+    PhysicsFields const &physics = simulation->physics;
+    auto query_cells = [&](auto &grid, uint32_t size) {
+        uint32_t sx = fclamp(x - w - size / 2, 0, ARENA_WIDTH - 1) / size;
+        uint32_t sy = fclamp(y - h - size / 2, 0, ARENA_HEIGHT - 1) / size;
+        uint32_t ex = fclamp(x + w + size / 2, 0, ARENA_WIDTH - 1) / size;
+        uint32_t ey = fclamp(y + h + size / 2, 0, ARENA_HEIGHT - 1) / size;
+        for (uint32_t _x = sx; _x <= ex; ++_x) {
+            for (uint32_t _y = sy; _y <= ey; ++_y) {
+                std::vector<EntityID> &cell = grid[_x][_y];
+                for (uint32_t i = 0; i < cell.size(); ++i) {
+                    //bounds come straight from the physics arrays, the entity
+                    //itself is only touched once it is inside the query box
+                    EntityID::id_type const id = cell[i].id;
+                    if (physics.x[id] + physics.radius[id] < x - w) continue;
+                    if (physics.x[id] - physics.radius[id] > x + w) continue;
+                    if (physics.y[id] + physics.radius[id] < y - h) continue;
+                    if (physics.y[id] - physics.radius[id] > y + h) continue;
+                    cb(simulation, simulation->get_ent(cell[i]));
+                }
+            }
+        }
+    };
+    query_cells(cells, GRID_SIZE);
+    if (coarse_count > 0) query_cells(coarse_cells, COARSE_GRID_SIZE);
+}
@@ -12,12 +12,13 @@
 
 Entity &alloc_drop(Simulation *sim, PetalID::T drop_id) {
     DEBUG_ONLY(assert(drop_id < PetalID::kNumPetals);)
-    PetalTracker::add_petal(sim, drop_id);
     Entity &drop = sim->alloc_ent();
+    //the world is full, see alloc_ent
+    if (drop.id != NULL_ENTITY) PetalTracker::add_petal(sim, drop_id);
     drop.add_component(kPhysics);
     drop.set_radius(25);
     drop.set_angle(frand() * 0.2 - 0.1);
-    drop.friction = 0.25;
+    drop.friction() = 0.25;
 
     drop.add_component(kRelations);
     drop.set_team(NULL_ENTITY);
@@ -40,8 +41,8 @@ static Entity &__alloc_mob(Simulation *sim, MobID::T mob_id, float x, float y, E
     mob.set_angle(frand() * 2 * M_PI);
     mob.set_x(x);
     mob.set_y(y);
-    mob.friction = DEFAULT_FRICTION;
-    mob.mass = (1 + mob.get_radius() / BASE_FLOWER_RADIUS) * (data.attributes.stationary ? 10000 : 1);
+    mob.friction() = DEFAULT_FRICTION;
+    mob.mass() = (1 + mob.get_radius() / BASE_FLOWER_RADIUS) * (data.attributes.stationary ? 10000 : 1);
     if (mob_id == MobID::kAntHole)
         BitMath::set(mob.flags, EntityFlags::kNoFriendlyCollision);
     if (team == NULL_ENTITY)
@@ -114,7 +115,7 @@ static Entity &__alloc_mob(Simulation *sim, MobID::T mob_id, float x, float y, E
             slot.update_id(sim, pid);
             slot.force_reload();
         }
-        for (uint32_t i = 0; i < loadout_slots_at_level(30); ++i)
+        for (uint32_t i = 0; i < loadout_slots_at_level(30) && mob.id != NULL_ENTITY; ++i)
             PetalTracker::add_petal(sim, mob.get_inventory(i));
     }
     return mob;
@@ -162,8 +163,8 @@ Entity &alloc_player(Simulation *sim, EntityID const team) {
 
     player.add_component(kPhysics);
     player.set_radius(BASE_FLOWER_RADIUS);
-    player.friction = DEFAULT_FRICTION;
-    player.mass = 1;
+    player.friction() = DEFAULT_FRICTION;
+    player.mass() = 1;
 
     player.add_component(kFlower);
 
@@ -195,8 +196,8 @@ Entity &alloc_petal(Simulation *sim, PetalID::T petal_id, Entity const &parent)
     petal.set_radius(petal_data.radius);
     if (petal_data.attributes.rotation_style == PetalAttributes::kPassiveRot)
         petal.set_angle(frand() * 2 * M_PI);
-    petal.mass = petal_data.attributes.mass;
-    petal.friction = DEFAULT_FRICTION * 1.5;
+    petal.mass() = petal_data.attributes.mass;
+    petal.friction() = DEFAULT_FRICTION * 1.5;
     petal.add_component(kRelations);
     petal.set_parent(parent.id);
     petal.set_team(parent.get_team());
@@ -223,8 +224,8 @@ Entity &alloc_web(Simulation *sim, float radius, Entity const &parent) {
     web.set_y(parent.get_y());
     web.set_angle(frand() * 2 * M_PI);
     web.set_radius(radius);
-    web.mass = 1.0;
-    web.friction = 1.0;
+    web.mass() = 1.0;
+    web.friction() = 1.0;
     web.add_component(kRelations);
     web.set_team(parent.get_team());
     web.set_parent(parent.id);
@@ -241,8 +242,8 @@ Entity& alloc_poison_web(Simulation* sim, float radius, Entity const& parent) {
     poison_web.set_y(parent.get_y());
     poison_web.set_angle(frand() * 2 * M_PI);
     poison_web.set_radius(radius);
-    poison_web.mass = 1.0;
-    poison_web.friction = 1.0;
+    poison_web.mass() = 1.0;
+    poison_web.friction() = 1.0;
     poison_web.add_component(kRelations);
     poison_web.set_team(parent.get_team());
     poison_web.set_parent(parent.id);
@@ -0,0 +1,23 @@
+#include <Server/TargetIndex.hh>
+
+#include <Shared/Simulation.hh>
+#include <Shared/Entity.hh>
+
+void TargetIndex::build(Simulation *sim) {
+    wild.clear();
+    owned.clear();
+    auto add = [&](Entity const &ent, uint32_t component) {
+        Target target = { ent.get_x(), ent.get_y(), ent.id, ent.get_team(), 1u << component };
+        if (target.team.null()) wild.push_back(target);
+        else owned.push_back(target);
+    };
+    sim->for_each<kMob>([&](Simulation *, Entity &ent) { add(ent, kMob); });
+    sim->for_each<kFlower>([&](Simulation *, Entity &ent) { add(ent, kFlower); });
+    std::sort(owned.begin(), owned.end(), [](Target const &a, Target const &b) { return a.x < b.x; });
+    wild_sorted = 0;
+}
+
+void TargetIndex::sort_wild() const {
+    std::sort(wild.begin(), wild.end(), [](Target const &a, Target const &b) { return a.x < b.x; });
+    wild_sorted = 1;
+}
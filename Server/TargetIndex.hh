@@ -0,0 +1,69 @@
+#pragma once
+
+#include <Shared/Entity.hh>
+
+#include <Helpers/Vector.hh>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+class Simulation;
+
+//every entity mobs can target, sorted by x once per tick. the arena is a
+//long strip, so a sweep over an x-window is a tight bound.
+//wild mobs (no team) only ever look at team-owned entities, which are few
+class TargetIndex {
+    struct Target {
+        float x;
+        float y;
+        EntityID id;
+        EntityID team;
+        //the one of kMob/kFlower it was added for, as a bit
+        uint32_t components;
+    };
+    //only team-owned queries need the wild list, so it is sorted on first use
+    mutable std::vector<Target> wild;
+    mutable uint8_t wild_sorted;
+    std::vector<Target> owned;
+public:
+    //snapshots every living mob and flower, positions must not change until
+    //the next build (the AI pass only moves entities it spawns)
+    void build(Simulation *);
+    //sorts the wild list ahead of the first team-owned query, which has to
+    //happen before nearest() is called from several threads at once
+    void sort_wild() const;
+    //nearest target within <radius> not on <team>, with one of the components
+    //in <mask>, that passes accept(EntityID); ties go to the lower id
+    template<typename F>
+    EntityID nearest(float, float, float, EntityID const &, uint32_t, F &&) const;
+};
+
+template<typename F>
+EntityID TargetIndex::nearest(float x, float y, float radius, EntityID const &team, uint32_t mask, F &&accept) const {
+    EntityID ret;
+    float min_dist = radius;
+    auto sweep = [&](std::vector<Target> const &targets) {
+        //the 1 unit of slack covers sqrtf rounding below |dx| or |dy|
+        auto it = std::lower_bound(targets.begin(), targets.end(), x - radius - 1, [](Target const &t, float v) {
+            return t.x < v;
+        });
+        for (; it != targets.end() && it->x <= x + min_dist + 1; ++it) {
+            if (std::abs(it->y - y) > min_dist + 1) continue;
+            if (!(it->components & mask)) continue;
+            if (it->team == team) continue;
+            float dist = Vector(it->x - x, it->y - y).magnitude();
+            if (dist > min_dist) continue;
+            if (dist == min_dist && (ret.null() || it->id.id > ret.id)) continue;
+            if (!accept(it->id)) continue;
+            min_dist = dist;
+            ret = it->id;
+        }
+    };
+    if (!team.null()) {
+        if (!wild_sorted) sort_wild();
+        sweep(wild);
+    }
+    sweep(owned);
+    return ret;
+}
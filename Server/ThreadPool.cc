@@ -0,0 +1,97 @@
+#include <Server/ThreadPool.hh>
+
+#include <algorithm>
+
+#ifndef WASM_SERVER
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#endif
+
+static uint32_t const MAX_THREADS = 16;
+
+static uint32_t thread_count = 0;
+
+#ifdef WASM_SERVER
+void ThreadPool::init(uint32_t) {
+    thread_count = 1;
+}
+
+uint32_t ThreadPool::size() {
+    return 1;
+}
+
+void ThreadPool::run(uint32_t n, void (*task)(void *, uint32_t), void *ctx) {
+    for (uint32_t i = 0; i < n; ++i) task(ctx, i);
+}
+#else
+//the current job, workers read it after seeing generation change
+struct Job {
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable done;
+    void (*task)(void *, uint32_t) = nullptr;
+    void *ctx = nullptr;
+    uint32_t size = 0;
+    uint32_t generation = 0;
+    uint32_t workers_busy = 0;
+    std::atomic<uint32_t> next = 0;
+};
+
+//never freed, detached workers still wait on it while static destructors run
+static Job *job = nullptr;
+
+static void _work() {
+    for (uint32_t i = job->next.fetch_add(1); i < job->size; i = job->next.fetch_add(1))
+        job->task(job->ctx, i);
+}
+
+static void _worker_loop() {
+    uint32_t seen = 0;
+    std::unique_lock<std::mutex> lock(job->mutex);
+    while (1) {
+        job->wake.wait(lock, [&](){ return job->generation != seen; });
+        seen = job->generation;
+        lock.unlock();
+        _work();
+        lock.lock();
+        if (--job->workers_busy == 0) job->done.notify_one();
+    }
+}
+
+void ThreadPool::init(uint32_t n) {
+    if (thread_count != 0) return;
+    if (n == 0) n = std::thread::hardware_concurrency();
+    thread_count = std::clamp<uint32_t>(n, 1, MAX_THREADS);
+    if (thread_count == 1) return;
+    job = new Job;
+    for (uint32_t i = 1; i < thread_count; ++i)
+        std::thread(_worker_loop).detach();
+}
+
+uint32_t ThreadPool::size() {
+    return thread_count;
+}
+
+void ThreadPool::run(uint32_t n, void (*task)(void *, uint32_t), void *ctx) {
+    if (thread_count == 0) init(0);
+    if (thread_count == 1 || n <= 1) {
+        for (uint32_t i = 0; i < n; ++i) task(ctx, i);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(job->mutex);
+        job->task = task;
+        job->ctx = ctx;
+        job->size = n;
+        job->next = 0;
+        job->workers_busy = thread_count - 1;
+        ++job->generation;
+    }
+    job->wake.notify_all();
+    _work();
+    std::unique_lock<std::mutex> lock(job->mutex);
+    job->done.wait(lock, [](){ return job->workers_busy == 0; });
+}
+#endif
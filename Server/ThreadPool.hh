@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+//a fixed set of worker threads that tick phases can split independent work over
+//the wasm server has no threads, everything runs on the calling thread there
+namespace ThreadPool {
+    //starts <n> - 1 workers, the calling thread is the n-th. 0 uses every core
+    //only the first call does anything, run() calls it with 0 if nobody did
+    void init(uint32_t);
+    //threads run() spreads tasks over, including the calling one
+    uint32_t size();
+    //task(ctx, i) for every i < n, returns once all of them are done
+    //tasks are claimed in order but may finish in any order. not reentrant
+    void run(uint32_t, void (*)(void *, uint32_t), void *);
+    //fn(i) for every i < n
+    template<typename F>
+    void parallel_for(uint32_t n, F &&fn) {
+        run(n, [](void *ctx, uint32_t i) {
+            (*static_cast<std::remove_reference_t<F> *>(ctx))(i);
+        }, (void *) &fn);
+    }
+}
@@ -0,0 +1,140 @@
+#include <Server/TickProfiler.hh>
+
+#include <Server/Server.hh>
+
+#include <Helpers/Array.hh>
+
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <vector>
+
+using namespace TickProfiler;
+
+std::array<char const *, TickPhase::kNumPhases> const TickProfiler::PHASE_NAMES = {
+    #define PHASE(name) #name,
+    PERPHASE
+    #undef PHASE
+};
+
+struct PhaseStats {
+    double mean;
+    uint64_t p50;
+    uint64_t p99;
+    uint64_t max;
+};
+
+static std::chrono::steady_clock::time_point lap_start;
+static TickSample current = {0};
+static TickSample finished = {0};
+static CircularArray<TickSample, PROFILER_HISTORY> history;
+
+//bucket i holds packets up to 64 << 2i bytes, the last one everything bigger
+static uint32_t const PACKET_BUCKETS = 7;
+static_assert((64ull << 2 * (PACKET_BUCKETS - 2)) == MAX_PACKET_LEN);
+static std::array<uint64_t, PACKET_BUCKETS> packet_sizes = {0};
+static size_t largest_packet = 0;
+
+//stats of <phase> over the last <n> ticks, kNumPhases gives the whole tick
+static PhaseStats _get_stats(uint8_t phase, uint32_t n) {
+    std::vector<uint64_t> values;
+    values.reserve(n);
+    for (uint32_t i = history.size() - n; i < history.size(); ++i) {
+        TickSample const &sample = history[i];
+        uint64_t v = 0;
+        if (phase < TickPhase::kNumPhases) v = sample[phase];
+        else for (uint64_t t : sample) v += t;
+        values.push_back(v);
+    }
+    uint64_t sum = 0;
+    for (uint64_t v : values) sum += v;
+    std::sort(values.begin(), values.end());
+    return {
+        .mean = sum / (double) n,
+        .p50 = values[(n - 1) / 2],
+        .p99 = values[(n - 1) * 99 / 100],
+        .max = values.back()
+    };
+}
+
+void TickProfiler::begin() {
+    current = {0};
+    lap_start = std::chrono::steady_clock::now();
+}
+
+void TickProfiler::lap(uint8_t phase) {
+    assert(phase < TickPhase::kNumPhases);
+    auto now = std::chrono::steady_clock::now();
+    current[phase] += std::chrono::duration_cast<std::chrono::nanoseconds>(now - lap_start).count();
+    lap_start = now;
+}
+
+void TickProfiler::end() {
+    finished = current;
+    history.push_back(current);
+}
+
+TickSample const &TickProfiler::last() {
+    return finished;
+}
+
+std::string TickProfiler::report(uint32_t n) {
+    n = std::min(n, history.size());
+    if (n == 0) return "no ticks recorded\n";
+    char line[128];
+    std::snprintf(line, sizeof(line), "last %u ticks (ms)\n%-12s %8s %8s %8s %8s\n", n, "phase", "mean", "p50", "p99", "max");
+    std::string ret = line;
+    for (uint8_t phase = 0; phase <= TickPhase::kNumPhases; ++phase) {
+        PhaseStats stats = _get_stats(phase, n);
+        std::snprintf(line, sizeof(line), "%-12s %8.3f %8.3f %8.3f %8.3f\n",
+            phase < TickPhase::kNumPhases ? PHASE_NAMES[phase] : "Total",
+            stats.mean / 1e6, stats.p50 / 1e6, stats.p99 / 1e6, stats.max / 1e6);
+        ret += line;
+    }
+    return ret;
+}
+
+std::string TickProfiler::summary(uint32_t n) {
+    n = std::min(n, history.size());
+    if (n == 0) return "no ticks recorded";
+    std::array<PhaseStats, TickPhase::kNumPhases> stats;
+    std::array<uint8_t, TickPhase::kNumPhases> order;
+    for (uint8_t phase = 0; phase < TickPhase::kNumPhases; ++phase) {
+        stats[phase] = _get_stats(phase, n);
+        order[phase] = phase;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](uint8_t a, uint8_t b) {
+        return stats[a].mean > stats[b].mean;
+    });
+    PhaseStats total = _get_stats(TickPhase::kNumPhases, n);
+    char line[64];
+    std::snprintf(line, sizeof(line), "tick %.2f/%.2fms", total.p50 / 1e6, total.p99 / 1e6);
+    std::string ret = line;
+    for (uint32_t i = 0; i < 3; ++i) {
+        std::snprintf(line, sizeof(line), ", %s %.2f/%.2f", PHASE_NAMES[order[i]],
+            stats[order[i]].p50 / 1e6, stats[order[i]].p99 / 1e6);
+        ret += line;
+    }
+    return ret;
+}
+
+void TickProfiler::record_packet(size_t size) {
+    uint32_t bucket = 0;
+    while (bucket < PACKET_BUCKETS - 1 && size > (64ull << 2 * bucket)) ++bucket;
+    ++packet_sizes[bucket];
+    largest_packet = std::max(largest_packet, size);
+}
+
+std::string TickProfiler::packet_report() {
+    char line[64];
+    std::string ret = "update packets (bytes)\n";
+    for (uint32_t bucket = 0; bucket < PACKET_BUCKETS; ++bucket) {
+        if (bucket < PACKET_BUCKETS - 1)
+            std::snprintf(line, sizeof(line), "<= %-9llu %llu\n", 64ull << 2 * bucket, (unsigned long long) packet_sizes[bucket]);
+        else
+            std::snprintf(line, sizeof(line), ">  %-9llu %llu\n", (unsigned long long) MAX_PACKET_LEN, (unsigned long long) packet_sizes[bucket]);
+        ret += line;
+    }
+    std::snprintf(line, sizeof(line), "largest %zu of %zu\n", largest_packet, MAX_PACKET_LEN);
+    return ret + line;
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+#define PERPHASE \
+    PHASE(ActiveSet) \
+    PHASE(Spawning) \
+    PHASE(Broadphase) \
+    PHASE(Culling) \
+    PHASE(Player) \
+    PHASE(Ai) \
+    PHASE(Petal) \
+    PHASE(Health) \
+    PHASE(Collision) \
+    PHASE(Motion) \
+    PHASE(Segment) \
+    PHASE(Camera) \
+    PHASE(Score) \
+    PHASE(References) \
+    PHASE(Leaderboard) \
+    PHASE(Replication) \
+    PHASE(PostTick)
+
+namespace TickPhase {
+    enum : uint8_t {
+        #define PHASE(name) k##name,
+        PERPHASE
+        #undef PHASE
+        kNumPhases
+    };
+};
+
+//number of finished ticks kept for runtime reports
+inline uint32_t const PROFILER_HISTORY = 4096;
+
+//nanoseconds spent in each phase of a single tick
+typedef std::array<uint64_t, TickPhase::kNumPhases> TickSample;
+
+namespace TickProfiler {
+    extern std::array<char const *, TickPhase::kNumPhases> const PHASE_NAMES;
+    //starts timing a new tick
+    void begin();
+    //attributes the time since the last begin/lap to <phase>
+    void lap(uint8_t);
+    //finishes the current tick and stores it in the history
+    void end();
+    //phase times of the last finished tick
+    TickSample const &last();
+    //mean/p50/p99/max of every phase over the last <n> ticks, one line per phase
+    std::string report(uint32_t);
+    //p50/p99 of the whole tick and its three slowest phases over the last <n> ticks
+    std::string summary(uint32_t);
+    //counts a client update packet of <size> bytes, on the game thread only
+    void record_packet(size_t);
+    //update packets seen so far by size, and the largest against MAX_PACKET_LEN
+    std::string packet_report();
+}
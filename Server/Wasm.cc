@@ -112,9 +112,9 @@ void Server::run() {
     }, 1000 / TPS);
 }
 
-void Client::send_packet(uint8_t const *packet, size_t size) {
+void Client::send_packet(std::string_view message) {
     if (ws == nullptr) return;
-    ws->send(packet, size);
+    ws->send(reinterpret_cast<uint8_t const *>(message.data()), message.size());
 }
 
 WebSocket::WebSocket(int id) : ws_id(id) {
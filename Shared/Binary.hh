@@ -2,8 +2,13 @@
 
 #include <Shared/EntityDef.hh>
 
+#include <algorithm>
+#include <bit>
+#include <cmath>
 #include <cstdint>
+#include <cstring>
 #include <string>
+#include <string_view>
 #include <vector>
 
 
@@ -29,9 +34,14 @@ enum CloseReason {
 };
 
 class Writer {
+    //the buffer written into, resized whenever a write would run past it
+    std::vector<uint8_t> *buffer;
+    void grow(size_t);
 public:
     uint8_t *at;
     uint8_t *packet;
+    //one past the last byte of the buffer
+    uint8_t *end;
     template<typename T>
     class Encoder {
         friend class Writer;
@@ -47,12 +57,23 @@ public:
         };
     };
 
-    Writer(uint8_t *);
+    //writes from the start of <buffer>. the buffer keeps whatever size it
+    //grew to, so writers reusing it only allocate on the first large packets
+    Writer(std::vector<uint8_t> &);
     template<typename T>
     void write(T const &v) {
         Encoder<T>::write(*this, v);
     };
+    //makes room for <n> more bytes, every write goes through here first
+    void reserve(size_t n) {
+        if (static_cast<size_t>(end - at) < n) grow(n);
+    }
     void push(uint8_t);
+    void write_bytes(uint8_t const *, size_t);
+    //unsigned LEB128. up to 8 bytes go out as a single store
+    void write_varint(uint64_t);
+    //what has been written so far, valid until the buffer is written to again
+    std::string_view view() const;
 };
 
 class Reader {
@@ -69,6 +90,11 @@ public:
         friend class Reader;
         static std::vector<T> read(Reader &r) {
             uint32_t len = r.read<uint32_t>();
+            if (len > (size_t) (r.end - r.at)) {
+                r.failed = 1;
+                r.at = r.end;
+                return {};
+            }
             std::vector<T> ret(len);
             for (uint32_t i = 0; i < len; ++i)
                 ret.push_back(r.read<T>());
@@ -78,6 +104,12 @@ public:
         static void read(Reader &r, std::vector<T> &v) {
             uint32_t len = r.read<uint32_t>();
             v.clear();
+            //every element is at least a byte, so a longer one can't fit
+            if (len > (size_t) (r.end - r.at)) {
+                r.failed = 1;
+                r.at = r.end;
+                return;
+            }
             v.reserve(len);
             for (uint32_t i = 0; i < len; ++i)
                 v.push_back(r.read<T>());
@@ -86,7 +118,11 @@ public:
 
     uint8_t const *packet;
     uint8_t const *at;
-    Reader(uint8_t const *);
+    //varints only read 8 bytes at once when that stays before end
+    uint8_t const *end;
+    //set once a read would have gone past end, every such read returns 0
+    uint8_t failed;
+    Reader(uint8_t const *, uint8_t const *);
 
     template<typename T>
     T read() {
@@ -99,6 +135,8 @@ public:
     }
 
     uint8_t next();
+    //unsigned LEB128 of at most <n> bytes, longer ones are cut off there
+    uint64_t read_varint(uint32_t);
 };
 
 class Validator {
@@ -113,3 +151,335 @@ public:
     uint8_t validate_float();
     uint8_t validate_string(uint32_t);
 };
+
+inline uint32_t const PROTOCOL_FLOAT_SCALE = 64;
+
+//everything a client update is made of is inlined here, the rest of the
+//codec is in Binary.cc
+
+inline void Writer::push(uint8_t val) {
+    reserve(1);
+    *at++ = val;
+}
+
+inline void Writer::write_bytes(uint8_t const *bytes, size_t size) {
+    reserve(size);
+    std::memcpy(at, bytes, size);
+    at += size;
+}
+
+inline std::string_view Writer::view() const {
+    return std::string_view(reinterpret_cast<char const *>(packet), at - packet);
+}
+
+inline void Writer::write_varint(uint64_t v) {
+    //10 bytes is the longest varint, and covers the 8 byte store too
+    reserve(10);
+    //field tags, flags and most ids
+    if (v < 128) {
+        *at++ = v;
+        return;
+    }
+    uint32_t const len = (std::bit_width(v) + 6) / 7;
+    if constexpr (std::endian::native == std::endian::little) {
+        if (len <= 8) {
+            //seven bits per byte, continuation bits on all but the last
+            uint64_t spread = 0;
+            for (uint32_t i = 0; i < 8; ++i)
+                spread |= (v << i) & (0x7full << (8 * i));
+            spread |= 0x8080808080808080ull >> (72 - 8 * len);
+            std::memcpy(at, &spread, 8);
+            at += len;
+            return;
+        }
+    }
+    for (uint32_t i = 1; i < len; ++i) {
+        *at++ = (v & 127) | 128;
+        v >>= 7;
+    }
+    *at++ = v;
+}
+
+inline uint8_t Reader::next() {
+    if (at >= end) {
+        failed = 1;
+        return 0;
+    }
+    return *at++;
+}
+
+inline uint64_t Reader::read_varint(uint32_t max_len) {
+    if (at >= end) {
+        failed = 1;
+        return 0;
+    }
+    if (*at <= 127) return *at++;
+    if constexpr (std::endian::native == std::endian::little) {
+        if (end - at >= 8) {
+            uint64_t word;
+            std::memcpy(&word, at, 8);
+            //the first byte without a continuation bit ends it, 9 if none does
+            uint32_t const len = std::countr_zero(~word & 0x8080808080808080ull) / 8 + 1;
+            if (len <= 8 && len <= max_len) {
+                if (len < 8) word &= (1ull << (8 * len)) - 1;
+                uint64_t ret = 0;
+                for (uint32_t i = 0; i < 8; ++i)
+                    ret |= (word >> i) & (0x7full << (7 * i));
+                at += len;
+                return ret;
+            }
+        }
+    }
+    uint64_t ret = 0;
+    for (uint32_t i = 0; i < max_len; ++i) {
+        if (at >= end) {
+            failed = 1;
+            return 0;
+        }
+        uint8_t o = *at++;
+        ret |= (o & 127ull) << (i * 7);
+        if (o <= 127) break;
+    }
+    return ret;
+}
+
+template<>
+inline void Writer::Encoder<uint8_t>::write(Writer &w, uint8_t const &val) {
+    w.push(val);
+}
+
+template<>
+inline void Writer::Encoder<uint16_t>::write(Writer &w, uint16_t const &val) {
+    w.write_varint(val);
+}
+
+template<>
+inline void Writer::Encoder<uint32_t>::write(Writer &w, uint32_t const &val) {
+    w.write_varint(val);
+}
+
+template<>
+inline void Writer::Encoder<uint64_t>::write(Writer &w, uint64_t const &val) {
+    w.write_varint(val);
+}
+
+template<>
+inline void Writer::Encoder<int32_t>::write(Writer &w, int32_t const &val) {
+    int32_t v = val;
+    uint32_t sign = v < 0;
+    if (sign) v *= -1;
+    v = (v << 1) | sign;
+    w.write<uint64_t>(v);
+}
+
+template<>
+inline void Writer::Encoder<int64_t>::write(Writer &w, int64_t const &val) {
+    int64_t v = val;
+    uint32_t sign = v < 0;
+    if (sign) v *= -1;
+    v = (v << 1) | sign;
+    w.write<uint64_t>(v);
+}
+
+template<>
+inline void Writer::Encoder<float>::write(Writer &w, float const &v) {
+    w.write<int64_t>(v * PROTOCOL_FLOAT_SCALE);
+}
+
+template<>
+inline void Writer::Encoder<double>::write(Writer &w, double const &v) {
+    w.write<int64_t>(v * PROTOCOL_FLOAT_SCALE);
+}
+
+template<>
+inline void Writer::Encoder<EntityID>::write(Writer &w, EntityID const &id) {
+    w.write<EntityID::id_type>(id.id);
+    if (id.id) w.write<EntityID::hash_type>(id.hash);
+}
+
+template<>
+inline uint8_t Reader::Decoder<uint8_t>::read(Reader &r) {
+    return r.next();
+}
+
+template<>
+inline uint16_t Reader::Decoder<uint16_t>::read(Reader &r) {
+    return r.read_varint(3);
+}
+
+template<>
+inline uint32_t Reader::Decoder<uint32_t>::read(Reader &r) {
+    return r.read_varint(5);
+}
+
+template<>
+inline uint64_t Reader::Decoder<uint64_t>::read(Reader &r) {
+    return r.read_varint(10);
+}
+
+template<>
+inline int32_t Reader::Decoder<int32_t>::read(Reader &r) {
+    uint32_t u = r.read<uint32_t>();
+    uint32_t s = u & 1;
+    int32_t ret = u >> 1;
+    if (s) ret *= -1;
+    return ret;
+}
+
+template<>
+inline int64_t Reader::Decoder<int64_t>::read(Reader &r) {
+    uint64_t u = r.read<uint64_t>();
+    uint32_t s = u & 1;
+    int64_t ret = u >> 1;
+    if (s) ret *= -1;
+    return ret;
+}
+
+template<>
+inline float Reader::Decoder<float>::read(Reader &r) {
+    return r.read<int64_t>() / (float) PROTOCOL_FLOAT_SCALE;
+}
+
+template<>
+inline double Reader::Decoder<double>::read(Reader &r) {
+    return r.read<int64_t>() / (double) PROTOCOL_FLOAT_SCALE;
+}
+
+template<>
+inline EntityID Reader::Decoder<EntityID>::read(Reader &r) {
+    EntityID::id_type id = r.read<EntityID::id_type>();
+    EntityID::hash_type hash = id ? r.read<EntityID::hash_type>() : 0;
+    return EntityID(id, hash);
+}
+
+template<>
+inline void Reader::Decoder<uint8_t>::read(Reader &r, uint8_t &ref) {
+    ref = r.read<uint8_t>();
+}
+
+template<>
+inline void Reader::Decoder<uint16_t>::read(Reader &r, uint16_t &ref) {
+    ref = r.read<uint16_t>();
+}
+
+template<>
+inline void Reader::Decoder<uint32_t>::read(Reader &r, uint32_t &ref) {
+    ref = r.read<uint32_t>();
+}
+
+template<>
+inline void Reader::Decoder<uint64_t>::read(Reader &r, uint64_t &ref) {
+    ref = r.read<uint64_t>();
+}
+
+template<>
+inline void Reader::Decoder<int32_t>::read(Reader &r, int32_t &ref) {
+    ref = r.read<int32_t>();
+}
+
+template<>
+inline void Reader::Decoder<int64_t>::read(Reader &r, int64_t &ref) {
+    ref = r.read<int64_t>();
+}
+
+template<>
+inline void Reader::Decoder<float>::read(Reader &r, float &ref) {
+    ref = r.read<float>();
+}
+
+template<>
+inline void Reader::Decoder<double>::read(Reader &r, double &ref) {
+    ref = r.read<double>();
+}
+
+template<>
+inline void Reader::Decoder<EntityID>::read(Reader &r, EntityID &ref) {
+    ref = r.read<EntityID>();
+}
+
+//how an entity field goes over the wire, the last argument of its PERFIELD
+//entry. client and server have to agree, so changing one is a protocol change
+//creates use write/read, updates write_update/read_update. State is what the
+//server keeps per entity and field between the two, MULTIPLE fields can only
+//use encodings without any
+namespace Wire {
+    struct None {};
+
+    inline void assign(float &ref, float v) { ref = v; }
+    inline void assign(LerpFloat &ref, float v) { ref.set(v); }
+    inline float anchor(float v) { return v; }
+    inline float anchor(LerpFloat const &v) { return v.anchor(); }
+
+    inline uint64_t zigzag(int64_t v) { return (uint64_t(v) << 1) ^ uint64_t(v >> 63); }
+    inline int64_t unzigzag(uint64_t v) { return int64_t(v >> 1) ^ -int64_t(v & 1); }
+
+    //encodings that send updates the same way as creates
+    template<typename W>
+    struct Absolute {
+        typedef None State;
+        template<typename T>
+        static void write(Writer &w, T const &v, None &) { W::encode(w, v); }
+        template<typename T>
+        static void write_update(Writer &w, T const &v, None &) { W::encode(w, v); }
+        template<typename T>
+        static void read_update(Reader &r, T &ref) { W::read(r, ref); }
+    };
+
+    //whatever Writer::write<T> and Reader::read<T> do
+    struct Raw : Absolute<Raw> {
+        template<typename T>
+        static void encode(Writer &w, T const &v) { w.write<T>(v); }
+        template<typename T>
+        static void read(Reader &r, T &ref) { r.read<T>(ref); }
+    };
+
+    //world distances in 1/16ths, anywhere in the arena fits 3 bytes
+    struct Coord : Absolute<Coord> {
+        static void encode(Writer &w, float v) { w.write<int64_t>(std::lround(v * 16)); }
+        template<typename T>
+        static void read(Reader &r, T &ref) { assign(ref, r.read<int64_t>() / 16.0f); }
+    };
+
+    //Coord whose updates are the change since the value last written, or
+    //the new value if that is shorter (teleports, respawns). the low bit
+    //tells which. every client that gets an update had the entity in view
+    //when the last value went out, so they all hold it
+    struct Position {
+        typedef int64_t State;
+        static void write(Writer &w, float v, State &sent) {
+            sent = std::lround(v * 16);
+            w.write<int64_t>(sent);
+        }
+        static void write_update(Writer &w, float v, State &sent) {
+            int64_t const now = std::lround(v * 16);
+            //a smaller value is never a longer varint
+            w.write_varint(std::min(zigzag(now - sent) << 1, (zigzag(now) << 1) | 1));
+            sent = now;
+        }
+        template<typename T>
+        static void read(Reader &r, T &ref) { Coord::read(r, ref); }
+        template<typename T>
+        static void read_update(Reader &r, T &ref) {
+            uint64_t const v = r.read<uint64_t>();
+            int64_t const n = unzigzag(v >> 1);
+            if (v & 1) assign(ref, n / 16.0f);
+            else assign(ref, (std::lround(anchor(ref) * 16) + n) / 16.0f);
+        }
+    };
+
+    //angles in 256ths of a turn, one byte
+    struct Angle : Absolute<Angle> {
+        static void encode(Writer &w, float v) {
+            w.write<uint8_t>(std::lround(v * (256 / (2 * M_PI))) & 255);
+        }
+        template<typename T>
+        static void read(Reader &r, T &ref) { assign(ref, r.read<uint8_t>() * (2 * M_PI / 256)); }
+    };
+
+    //0 to 1 in 255ths, one byte
+    struct Ratio : Absolute<Ratio> {
+        static void encode(Writer &w, float v) { w.write<uint8_t>(std::lround(fclamp(v, 0, 1) * 255)); }
+        template<typename T>
+        static void read(Reader &r, T &ref) { assign(ref, r.read<uint8_t>() / 255.0f); }
+    };
+}
@@ -1,35 +1,57 @@
 #include <Shared/Entity.hh>
 
 #include <Shared/Binary.hh>
+#include <Shared/Simulation.hh>
 #include <Shared/StaticData.hh>
 
 #include <Shared/Binary.hh>
 
+#ifdef SERVERSIDE
+Entity::Entity(uint32_t slot) : slot(slot) {
+    init();
+}
+#else
 Entity::Entity() {
     init();
 }
+#endif
+
+SERVER_ONLY(static uint64_t snapshot_versions = 0;)
 
 void Entity::init() {
     components = 0;
     pending_delete = 0;
     lifetime = 0;
-    #define SINGLE(component, name, type) name = {};
-    #define MULTIPLE(component, name, type, amt) for (uint32_t n = 0; n < amt; ++n) { name[n] = {}; }
+    SERVER_ONLY(snapshot_version = ++snapshot_versions;)
+    #define SINGLE(component, name, type, wire) name = {};
+    #define MULTIPLE(component, name, type, amt, wire) for (uint32_t n = 0; n < amt; ++n) { name[n] = {}; }
+    #ifdef SERVERSIDE
+    #undef HOT
+    #define HOT(component, name, type, wire) Simulation::physics.name[slot] = {};
+    #endif
     PERFIELD
+    #ifdef SERVERSIDE
+    #undef HOT
+    #define HOT(component, name, type, wire) SINGLE(component, name, type, wire)
+    #endif
     #undef SINGLE
     #undef MULTIPLE
     #define SINGLE(name, type, reset) name reset;
     #define MULTIPLE(name, type, amt, reset) for (uint32_t i = 0; i < amt; ++i) { name[i] reset; }
     PER_EXTRA_FIELD
     #undef SINGLE
+    #define SINGLE(name, type, reset) name() reset;
+    SERVER_ONLY(PER_HOT_EXTRA_FIELD)
+    #undef SINGLE
     #undef MULTIPLE
     reset_protocol();
 }
 
 void Entity::reset_protocol() {
+    SERVER_ONLY(if (has_dirty_fields()) snapshot_version = ++snapshot_versions;)
     for (uint32_t n = 0; n < div_round_up(kFieldCount, 8); ++n) state[n] = 0;
-    #define SINGLE(component, name, type);
-    #define MULTIPLE(component, name, type, amt); for (uint32_t n = 0; n < div_round_up(amt, 8); ++n) { state_per_##name[n] = 0; }
+    #define SINGLE(component, name, type, wire);
+    #define MULTIPLE(component, name, type, amt, wire); for (uint32_t n = 0; n < div_round_up(amt, 8); ++n) { state_per_##name[n] = 0; }
     PERFIELD
     #undef SINGLE
     #undef MULTIPLE
@@ -40,33 +62,41 @@ void Entity::add_component(uint32_t comp) {
     BitMath::set(components, comp);
 }
 
-uint8_t Entity::has_component(uint32_t comp) const {
-    return BitMath::at(components, comp);
-}
-
-#define SINGLE(component, name, type) \
+#define SINGLE(component, name, type, wire) \
 type const &Entity::get_##name() const { \
     DEBUG_ONLY(assert(has_component(k##component));) \
     return name; \
 }
-#define MULTIPLE(component, name, type, amt) \
+#define MULTIPLE(component, name, type, amt, wire) \
 type const &Entity::get_##name(uint32_t i) const { \
     DEBUG_ONLY(assert(has_component(k##component));) \
     return name[i]; \
 }
+#ifdef SERVERSIDE
+#undef HOT
+#define HOT(component, name, type, wire) \
+type const &Entity::get_##name() const { \
+    DEBUG_ONLY(assert(has_component(k##component));) \
+    return Simulation::physics.name[slot]; \
+}
+#endif
 PERFIELD
+#ifdef SERVERSIDE
+#undef HOT
+#define HOT(component, name, type, wire) SINGLE(component, name, type, wire)
+#endif
 #undef SINGLE
 #undef MULTIPLE
 
 #ifdef SERVERSIDE
-#define SINGLE(component, name, type) \
+#define SINGLE(component, name, type, wire) \
 void Entity::set_##name(type const &v) { \
     DEBUG_ONLY(assert(has_component(k##component));) \
     if (name == v) return; \
     name = v; \
     BitMath::set_arr(state, k##name); \
 }
-#define MULTIPLE(component, name, type, amt) \
+#define MULTIPLE(component, name, type, amt, wire) \
 void Entity::set_##name(uint32_t i, type const &v) { \
     DEBUG_ONLY(assert(has_component(k##component));) \
     if (name[i] == v) return; \
@@ -74,18 +104,38 @@ void Entity::set_##name(uint32_t i, type const &v) { \
     BitMath::set_arr(state, k##name); \
     BitMath::set_arr(state_per_##name, i); \
 }
+#undef HOT
+#define HOT(component, name, type, wire) \
+void Entity::set_##name(type const &v) { \
+    DEBUG_ONLY(assert(has_component(k##component));) \
+    type &field = Simulation::physics.name[slot]; \
+    if (field == v) return; \
+    field = v; \
+    BitMath::set_arr(state, k##name); \
+}
 PERFIELD
+#undef HOT
+#define HOT(component, name, type, wire) SINGLE(component, name, type, wire)
 #undef SINGLE
 #undef MULTIPLE
 
-template<>
-void Entity::write<true>(Writer *writer) {
+uint8_t Entity::has_dirty_fields() const {
+    for (uint32_t n = 0; n < div_round_up(kFieldCount, 8); ++n)
+        if (state[n]) return 1;
+    return 0;
+}
+
+void Entity::write_create_header(Writer *writer) {
     writer->write<uint32_t>(components);
     writer->write<uint32_t>(lifetime);
-    #define SINGLE(component, name, type) { writer->write<type>(name); }
-    #define MULTIPLE(component, name, type, amt) { \
+}
+
+void Entity::write_create_fields(Writer *writer) {
+    Wire::None none;
+    #define SINGLE(component, name, type, wire) { Wire::wire::write(*writer, get_##name(), sent_##name); }
+    #define MULTIPLE(component, name, type, amt, wire) { \
         for (uint32_t n = 0; n < amt; ++n) \
-            writer->write<type>(name[n]); \
+            Wire::wire::write(*writer, name[n], none); \
     }
     #define COMPONENT(name) if (has_component(k##name)) { FIELDS_##name }
     PERCOMPONENT
@@ -94,20 +144,27 @@ void Entity::write<true>(Writer *writer) {
     #undef COMPONENT
 }
 
+template<>
+void Entity::write<true>(Writer *writer) {
+    write_create_header(writer);
+    write_create_fields(writer);
+}
+
 template<>
 void Entity::write<false>(Writer *writer) {
-    #define SINGLE(component, name, type) \
+    Wire::None none;
+    #define SINGLE(component, name, type, wire) \
         if(BitMath::at_arr(state, k##name)) { \
             writer->write<uint8_t>(k##name); \
-            writer->write<type>(name); \
+            Wire::wire::write_update(*writer, get_##name(), sent_##name); \
     }
-    #define MULTIPLE(component, name, type, amt) \
+    #define MULTIPLE(component, name, type, amt, wire) \
         if(BitMath::at_arr(state, k##name)) { \
             writer->write<uint8_t>(k##name); \
             for (uint32_t n = 0; n < amt; ++n) { \
                 if (BitMath::at_arr(state_per_##name, n)) { \
                     writer->write<uint8_t>(n); \
-                    writer->write<type>(name[n]); \
+                    Wire::wire::write_update(*writer, name[n], none); \
                 } \
             } \
             writer->write<uint8_t>(amt); \
@@ -130,12 +187,12 @@ template<>
 void Entity::read<true>(Reader *reader) {
     components = reader->read<uint32_t>();
     lifetime = reader->read<uint32_t>();
-    #define SINGLE(component, name, type) { reader->read<type>(name); BitMath::set_arr(state, k##name); }
-    #define MULTIPLE(component, name, type, amt) { \
+    #define SINGLE(component, name, type, wire) { Wire::wire::read(*reader, name); BitMath::set_arr(state, k##name); }
+    #define MULTIPLE(component, name, type, amt, wire) { \
         BitMath::set_arr(state, k##name); \
         for (uint32_t n = 0; n < amt; ++n) { \
             BitMath::set_arr(state_per_##name, n); \
-            reader->read<type>(name[n]); \
+            Wire::wire::read(*reader, name[n]); \
         } \
     }
     #define COMPONENT(name) if (has_component(k##name)) { FIELDS_##name }
@@ -151,17 +208,17 @@ void Entity::read<false>(Reader *reader) {
     while(1) {
         switch(reader->read<uint8_t>()) {
             case kFieldCount: { return; }
-            #define SINGLE(component, name, type) case k##name: { \
-                reader->read<type>(name); \
+            #define SINGLE(component, name, type, wire) case k##name: { \
+                Wire::wire::read_update(*reader, name); \
                 BitMath::set_arr(state, k##name); \
                 break; \
             }
-            #define MULTIPLE(component, name, type, amt) case k##name: { \
+            #define MULTIPLE(component, name, type, amt, wire) case k##name: { \
                 BitMath::set_arr(state, k##name); \
                 while (1) { \
                     uint8_t index = reader->read<uint8_t>(); \
                     if (index >= amt) break; \
-                    reader->read<type>(name[index]); \
+                    Wire::wire::read_update(*reader, name[index]); \
                     BitMath::set_arr(state_per_##name, index); \
                 } \
                 break; \
@@ -178,13 +235,13 @@ void Entity::read(Reader *reader, uint8_t create) {
     else read<false>(reader);
 }
 
-#define SINGLE(component, name, type) \
+#define SINGLE(component, name, type, wire) \
 uint8_t Entity::get_state_##name() const { \
     DEBUG_ONLY(assert(has_component(k##component));) \
     return BitMath::at_arr(state, k##name); \
 }
 
-#define MULTIPLE(component, name, type, amt) \
+#define MULTIPLE(component, name, type, amt, wire) \
 uint8_t Entity::get_state_##name(uint32_t i) const { \
     DEBUG_ONLY(assert(has_component(k##component));) \
     return BitMath::at_arr(state_per_##name, i); \
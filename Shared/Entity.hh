@@ -1,5 +1,6 @@
 #pragma once
 
+#include <Shared/Binary.hh>
 #include <Shared/EntityDef.hh>
 
 #include <Helpers/Array.hh>
@@ -11,9 +12,6 @@
 
 typedef CircularArray<PetalID::T, MAX_SLOT_COUNT> circ_arr_t;
 
-SERVER_ONLY(class Writer;)
-CLIENT_ONLY(class Reader;)
-
 SERVER_ONLY(typedef uint8_t StickyFlag;)
 CLIENT_ONLY(typedef PersistentFlag StickyFlag;)
 
@@ -29,27 +27,50 @@ enum Components {
 
 class Entity {
     enum Fields {
-        #define SINGLE(component, name, type) k##name,
-        #define MULTIPLE(component, name, type, amt) k##name,
+        #define SINGLE(component, name, type, wire) k##name,
+        #define MULTIPLE(component, name, type, amt, wire) k##name,
         PERFIELD
         #undef SINGLE
         #undef MULTIPLE
         kFieldCount
     };
     uint32_t components;
-#define SINGLE(component, name, type) type name;
-#define MULTIPLE(component, name, type, amt) type name[amt];
+#define SINGLE(component, name, type, wire) type name;
+#define MULTIPLE(component, name, type, amt, wire) type name[amt];
+#ifdef SERVERSIDE
+//stored in Simulation::physics[slot] instead
+#undef HOT
+#define HOT(component, name, type, wire)
+#endif
     PERFIELD
+#ifdef SERVERSIDE
+#undef HOT
+#define HOT(component, name, type, wire) SINGLE(component, name, type, wire)
+#endif
 #undef SINGLE
 #undef MULTIPLE
     uint8_t state[div_round_up(kFieldCount, 8)];
-#define SINGLE(component, name, type);
-#define MULTIPLE(component, name, type, amt) uint8_t state_per_##name[div_round_up(amt, 8)];
+#define SINGLE(component, name, type, wire);
+#define MULTIPLE(component, name, type, amt, wire) uint8_t state_per_##name[div_round_up(amt, 8)];
+    PERFIELD
+#undef SINGLE
+#undef MULTIPLE
+#ifdef SERVERSIDE
+    //what the field's Wire encoding remembers between writes
+#define SINGLE(component, name, type, wire) Wire::wire::State sent_##name;
+#define MULTIPLE(component, name, type, amt, wire)
     PERFIELD
 #undef SINGLE
 #undef MULTIPLE
+    //index of the HOT fields in Simulation::physics, fixed at construction
+    uint32_t slot;
+#endif
 public:
+#ifdef SERVERSIDE
+    Entity(uint32_t);
+#else
     Entity();
+#endif
     void init();
     void reset_protocol();
     Entity(Entity const &) = delete;
@@ -58,11 +79,13 @@ public:
     uint32_t lifetime;
     EntityID id;
     uint8_t pending_delete;
+    //changes whenever the fields may have, never repeats across entities
+    SERVER_ONLY(uint64_t snapshot_version;)
     void add_component(uint32_t);
     uint8_t has_component(uint32_t) const;
 
-#define SINGLE(component, name, type) type const &get_##name() const;
-#define MULTIPLE(component, name, type, amt) type const &get_##name(uint32_t) const;
+#define SINGLE(component, name, type, wire) type const &get_##name() const;
+#define MULTIPLE(component, name, type, amt, wire) type const &get_##name(uint32_t) const;
     PERFIELD
 #undef SINGLE
 #undef MULTIPLE
@@ -72,14 +95,26 @@ public:
     PER_EXTRA_FIELD
 #undef SINGLE
 #undef MULTIPLE
+#ifdef SERVERSIDE
+    //defined in Simulation.hh
+#define SINGLE(name, type, reset) type &name(); type const &name() const;
+    PER_HOT_EXTRA_FIELD
+#undef SINGLE
+#endif
 
 #ifdef SERVERSIDE
     void write(Writer *, uint8_t);
+    //write<true> is the header followed by every field of every component,
+    //the fields alone can be reused while snapshot_version holds
+    void write_create_header(Writer *);
+    void write_create_fields(Writer *);
+    //nonzero if a field was set since the last reset_protocol
+    uint8_t has_dirty_fields() const;
 
     template<bool>
     void write(Writer *);
-#define SINGLE(component, name, type) void set_##name(type const &);
-#define MULTIPLE(component, name, type, amt) void set_##name(uint32_t, type const &);
+#define SINGLE(component, name, type, wire) void set_##name(type const &);
+#define MULTIPLE(component, name, type, amt, wire) void set_##name(uint32_t, type const &);
     PERFIELD
 #undef SINGLE
 #undef MULTIPLE
@@ -90,10 +125,14 @@ public:
     template<bool>
     void read(Reader *);
 
-    #define SINGLE(component, name, type) uint8_t get_state_##name() const;
-    #define MULTIPLE(component, name, type, amt) uint8_t get_state_##name(uint32_t) const;
+    #define SINGLE(component, name, type, wire) uint8_t get_state_##name() const;
+    #define MULTIPLE(component, name, type, amt, wire) uint8_t get_state_##name(uint32_t) const;
     PERFIELD
     #undef SINGLE
     #undef MULTIPLE
 #endif
-};
\ No newline at end of file
+};
+
+inline uint8_t Entity::has_component(uint32_t comp) const {
+    return BitMath::at(components, comp);
+}
\ No newline at end of file
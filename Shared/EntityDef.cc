@@ -11,8 +11,8 @@ bool EntityID::null() const {
     return id == 0;
 }
 
-uint32_t EntityID::make_hash(EntityID const o) {
-    return o.id * 65536 + o.hash;
+uint64_t EntityID::make_hash(EntityID const o) {
+    return o.id * 65536ull + o.hash;
 }
 
 bool EntityID::equal_to(EntityID const a, EntityID const b) {
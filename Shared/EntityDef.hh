@@ -3,9 +3,20 @@
 #include <Shared/StaticDefinitions.hh>
 
 #include <cstdint>
+#include <type_traits>
 
 typedef uint16_t game_tick_t;
 
+//build with -DENTITY_CAP=<n> (CMake) to change it, client and server must match
+//the server reserves about 800 bytes per slot up front (Entity, physics
+//arrays, per-component id lists) and commits it as the world fills up
+#ifdef CUSTOM_ENTITY_CAP
+inline uint32_t const ENTITY_CAP = CUSTOM_ENTITY_CAP;
+#else
+inline uint32_t const ENTITY_CAP = 8192;
+#endif
+static_assert(ENTITY_CAP > 1 && ENTITY_CAP <= (1 << 20));
+
 #define PERCOMPONENT \
     COMPONENT(Physics) \
     COMPONENT(Camera) \
@@ -34,46 +45,51 @@ FIELDS_Segmented \
 FIELDS_Score \
 FIELDS_Name
 
+//HOT fields are stored in Simulation's per-field arrays on the server
+//(see PhysicsFields), everywhere else they behave like SINGLE
+//the last argument of every field is its Wire encoding, see Shared/Binary.hh
+#define HOT(component, name, type, wire) SINGLE(component, name, type, wire)
+
 #define FIELDS_Physics \
-SINGLE(Physics, x, Float) \
-SINGLE(Physics, y, Float) \
-SINGLE(Physics, radius, Float) \
-SINGLE(Physics, angle, Float)
+HOT(Physics, x, Float, Position) \
+HOT(Physics, y, Float, Position) \
+HOT(Physics, radius, Float, Coord) \
+SINGLE(Physics, angle, Float, Angle)
 
 #define FIELDS_Camera \
-SINGLE(Camera, player, EntityID) \
-SINGLE(Camera, respawn_level, uint8_t) \
-MULTIPLE(Camera, inventory, PetalID::T, 2 * MAX_SLOT_COUNT) \
-SINGLE(Camera, killed_by, std::string) \
-SINGLE(Camera, camera_x, Float) \
-SINGLE(Camera, camera_y, Float) \
-SINGLE(Camera, fov, Float) 
+SINGLE(Camera, player, EntityID, Raw) \
+SINGLE(Camera, respawn_level, uint8_t, Raw) \
+MULTIPLE(Camera, inventory, PetalID::T, 2 * MAX_SLOT_COUNT, Raw) \
+SINGLE(Camera, killed_by, std::string, Raw) \
+SINGLE(Camera, camera_x, Float, Coord) \
+SINGLE(Camera, camera_y, Float, Coord) \
+SINGLE(Camera, fov, Float, Raw) 
 
 #define FIELDS_Relations \
-SINGLE(Relations, team, EntityID) \
-SINGLE(Relations, parent, EntityID) \
-SINGLE(Relations, color, uint8_t)
+SINGLE(Relations, team, EntityID, Raw) \
+SINGLE(Relations, parent, EntityID, Raw) \
+SINGLE(Relations, color, uint8_t, Raw)
 
 #define FIELDS_Flower \
-SINGLE(Flower, overlevel_timer, float) \
-SINGLE(Flower, loadout_count, uint8_t) \
-SINGLE(Flower, face_flags, uint8_t) \
-SINGLE(Flower, equip_flags, uint8_t) \
-MULTIPLE(Flower, loadout_ids, PetalID::T, 2 * MAX_SLOT_COUNT) \
-MULTIPLE(Flower, loadout_reloads, uint8_t, MAX_SLOT_COUNT)
+SINGLE(Flower, overlevel_timer, float, Raw) \
+SINGLE(Flower, loadout_count, uint8_t, Raw) \
+SINGLE(Flower, face_flags, uint8_t, Raw) \
+SINGLE(Flower, equip_flags, uint8_t, Raw) \
+MULTIPLE(Flower, loadout_ids, PetalID::T, 2 * MAX_SLOT_COUNT, Raw) \
+MULTIPLE(Flower, loadout_reloads, uint8_t, MAX_SLOT_COUNT, Raw)
 
 #define FIELDS_Petal \
-SINGLE(Petal, petal_id, PetalID::T)
+SINGLE(Petal, petal_id, PetalID::T, Raw)
 
 #define FIELDS_Health \
-SINGLE(Health, health_ratio, Float) \
-SINGLE(Health, damaged, StickyFlag)
+SINGLE(Health, health_ratio, Float, Ratio) \
+SINGLE(Health, damaged, StickyFlag, Raw)
 
 #define FIELDS_Mob \
-SINGLE(Mob, mob_id, MobID::T)
+SINGLE(Mob, mob_id, MobID::T, Raw)
 
 #define FIELDS_Drop \
-SINGLE(Drop, drop_id, PetalID::T)
+SINGLE(Drop, drop_id, PetalID::T, Raw)
 
 #define FIELDS_Segmented
 
@@ -81,21 +97,23 @@ SINGLE(Drop, drop_id, PetalID::T)
 #define FIELDS_PoisonWeb
 
 #define FIELDS_Score \
-SINGLE(Score, score, uint32_t)
+SINGLE(Score, score, uint32_t, Raw)
 
 #define FIELDS_Name \
-SINGLE(Name, name, std::string) \
-SINGLE(Name, nametag_visible, uint8_t)
+SINGLE(Name, name, std::string, Raw) \
+SINGLE(Name, nametag_visible, uint8_t, Raw)
 
 #ifdef SERVERSIDE
-#define PER_EXTRA_FIELD \
+//extra fields that live in PhysicsFields next to the HOT ones
+#define PER_HOT_EXTRA_FIELD \
     SINGLE(velocity, Vector, .set(0,0)) \
     SINGLE(collision_velocity, Vector, .set(0,0)) \
     SINGLE(acceleration, Vector, .set(0,0)) \
     SINGLE(friction, float, =0) \
     SINGLE(mass, float, =1) \
-    SINGLE(speed_ratio, float, =1) \
-    \
+    SINGLE(speed_ratio, float, =1)
+
+#define PER_EXTRA_FIELD \
     MULTIPLE(loadout, LoadoutSlot, MAX_SLOT_COUNT, .reset()) \
     SINGLE(heading_angle, float, =0) \
     SINGLE(input, uint8_t, =0) \
@@ -150,12 +168,13 @@ SINGLE(Name, nametag_visible, uint8_t)
 class EntityID {
 public:
     typedef uint8_t hash_type;
-    typedef uint16_t id_type;
+    //ids are varints on the wire, so a wider type only costs bytes for high ids
+    typedef std::conditional_t<(ENTITY_CAP <= 65536), uint16_t, uint32_t> id_type;
     id_type id;
     hash_type hash;
     EntityID();
     EntityID(id_type, hash_type);
-    static uint32_t make_hash(EntityID const);
+    static uint64_t make_hash(EntityID const);
     static bool equal_to(EntityID const, EntityID const);
     bool null() const;
 };
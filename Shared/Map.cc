@@ -43,6 +43,8 @@ void Map::remove_mob(Simulation *sim, uint32_t zone) {
 void Map::spawn_random_mob(Simulation *sim, float x, float y) {
     uint32_t zone_id = Map::get_zone_from_pos(x, y);
     struct ZoneDefinition const &zone = MAP_DATA[zone_id];
+    //zone mobs are optional, keep the last slots for players, petals and drops
+    if (sim->free_ent_count() < ENTITY_CAP / 32) return;
     if (zone.density * (zone.right - zone.left) * (zone.bottom - zone.top) / (500 * 500) < sim->zone_mob_counts[zone_id]) return;
     float sum = 0;
     for (SpawnChance const &s : zone.spawns)
@@ -55,7 +57,7 @@ void Map::spawn_random_mob(Simulation *sim, float x, float y) {
             ent.zone = zone_id;
             ent.immunity_ticks = TPS;
             BitMath::set(ent.flags, EntityFlags::kSpawnedFromZone);
-            sim->zone_mob_counts[zone_id]++;
+            if (ent.id != NULL_ENTITY) sim->zone_mob_counts[zone_id]++;
             return;
         }
     }
@@ -1,4 +1,9 @@
 #include <Shared/Simulation.hh>
+
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <new>
 #ifdef DEBUG
 #include <iostream>
 
@@ -7,49 +12,80 @@ std::ostream &operator<<(std::ostream &out, EntityID const &id) {
 }
 #endif
 
-Simulation::Simulation() SERVER_ONLY(: spatial_hash(this)) {
+Simulation::Simulation() :
+    entities(static_cast<Entity *>(::operator new(sizeof(Entity) * (ENTITY_CAP + 1)))),
+    constructed_count(0)
+    SERVER_ONLY(, spatial_hash(this))
+{
+    //slot 0 backs NULL_ENTITY lookups
+    _construct_slots(0);
+    new (&entities[ENTITY_CAP]) Entity(SERVER_ONLY(ENTITY_CAP));
     reset();
 }
 
+void Simulation::_construct_slots(uint32_t last) {
+    for (; constructed_count <= last; ++constructed_count)
+        new (&entities[constructed_count]) Entity(SERVER_ONLY(constructed_count));
+}
+
 void Simulation::reset() {
     active_entities.clear();
+    for (uint32_t i = 0; i < kComponentCount; ++i)
+        component_entities[i].clear();
     hash_tracker = {0};
     entity_tracker = {0};
+    first_free_word = 0;
+    entity_count = 0;
     
-    for (EntityID::id_type i = 0; i < ENTITY_CAP; ++i)
+    for (uint32_t i = 0; i < constructed_count; ++i)
         entities[i].init();
 
     arena_info.init();
     #ifdef SERVERSIDE
-    spatial_hash.refresh(ARENA_WIDTH, ARENA_HEIGHT);
+    spatial_hash.clear();
     petal_count_tracker = {0};
     zone_mob_counts = {0};
     #endif
 }
 
 Entity &Simulation::alloc_ent() {
-    for (EntityID::id_type i = 1; i < ENTITY_CAP; ++i) {
-        if (BitMath::at_arr(entity_tracker.data(), i)) continue;
+    //lowest free slot, same order as a linear scan from 1
+    for (uint32_t w = first_free_word; w < entity_tracker.size(); ++w) {
+        uint64_t free = ~entity_tracker[w];
+        //slot 0 is NULL_ENTITY
+        if (w == 0) BitMath::unset(free, 0);
+        if (free == 0) continue;
+        uint32_t i = w * 64 + std::countr_zero(free);
+        if (i >= ENTITY_CAP) break;
+        first_free_word = w;
         BitMath::set_arr(entity_tracker.data(), i);
+        ++entity_count;
+        _construct_slots(i);
         entities[i].init();
         DEBUG_ONLY(std::cout << "ent_create " << EntityID(i, hash_tracker[i]) << "\n";)
         entities[i].id = EntityID(i, hash_tracker[i]);
         return entities[i];
     }
-    assert(!"Entity cap reached");
-}
-
-Entity &Simulation::get_ent(EntityID const &id) {
-    DEBUG_ONLY(assert(ent_exists(id));)
-    return entities[id.id];
+    if (first_free_word < entity_tracker.size())
+        std::printf("entity cap reached (%u entities)\n", entity_count);
+    first_free_word = entity_tracker.size();
+    //hand out a detached scratch entity instead of aborting. it is never
+    //tracked, so it is not ticked or sent, and anything that keeps its id
+    //just sees NULL_ENTITY, a dead entity. it lives past the last slot so
+    //get_ent(NULL_ENTITY) never sees what the caller writes into it
+    entities[ENTITY_CAP].init();
+    entities[ENTITY_CAP].id = NULL_ENTITY;
+    return entities[ENTITY_CAP];
 }
 
 void Simulation::force_alloc_ent(EntityID const &id) {
     assert(id.id < ENTITY_CAP);
     DEBUG_ONLY(std::cout << "ent_create " << id << "\n";)
     assert(!BitMath::at_arr(entity_tracker.data(), id.id));
+    _construct_slots(id.id);
     entities[id.id].init();
     BitMath::set_arr(entity_tracker.data(), id.id);
+    ++entity_count;
     hash_tracker[id.id] = id.hash;
     entities[id.id].id = id;
 }
@@ -59,6 +95,10 @@ uint8_t Simulation::ent_exists(EntityID const &id) const {
     return BitMath::at_arr(entity_tracker.data(), id.id) && hash_tracker[id.id] == id.hash;
 }
 
+uint32_t Simulation::free_ent_count() const {
+    return ENTITY_CAP - 1 - entity_count;
+}
+
 uint8_t Simulation::ent_alive(EntityID const &id) const {
     return ent_exists(id) && !entities[id.id].pending_delete
     SERVER_ONLY(&& entities[id.id].deletion_tick == 0);
@@ -73,35 +113,28 @@ void Simulation::_delete_ent(EntityID const &id) {
     DEBUG_ONLY(std::cout << "ent_delete " << id << "\n";)
     DEBUG_ONLY(assert(ent_exists(id)));
     BitMath::unset_arr(entity_tracker.data(), id.id);
+    SERVER_ONLY(spatial_hash.remove(id);)
     hash_tracker[id.id]++;
+    --entity_count;
+    first_free_word = std::min<uint32_t>(first_free_word, id.id / 64);
 }
 
-void Simulation::tick() {
+void Simulation::rebuild_entity_lists() {
     active_entities.clear();
-    for (EntityID::id_type i = 1; i < ENTITY_CAP; ++i) {
-        if (!BitMath::at_arr(entity_tracker.data(), i)) continue;
-        active_entities.push(entities[i].id.id);
+    for (uint32_t i = 0; i < kComponentCount; ++i)
+        component_entities[i].clear();
+    //walk the set bits of each tracker word, in ascending id order
+    for (uint32_t w = 0; w < entity_tracker.size(); ++w) {
+        for (uint64_t word = entity_tracker[w]; word != 0; word &= word - 1) {
+            Entity const &ent = entities[w * 64 + std::countr_zero(word)];
+            active_entities.push(ent.id.id);
+            for (uint32_t j = 0; j < kComponentCount; ++j)
+                if (ent.has_component(j)) component_entities[j].push(ent.id.id);
+        }
     }
-    on_tick();
-}
-
-void Simulation::for_each_entity(std::function<void(Simulation *, Entity &)> cb) { \
-    for (EntityID::id_type i = 0; i < active_entities.size(); ++i) { \
-        if (!BitMath::at_arr(entity_tracker.data(), active_entities[i])) continue; \
-        Entity &ent = entities[active_entities[i]]; \
-        cb(this, ent); \
-    } \
 }
 
-#define COMPONENT(name) \
-template<> \
-void Simulation::for_each<k##name>(std::function<void(Simulation *, Entity &)> cb) { \
-    for (EntityID::id_type i = 0; i < active_entities.size(); ++i) { \
-        if (!BitMath::at_arr(entity_tracker.data(), active_entities[i])) continue; \
-        Entity &ent = entities[active_entities[i]]; \
-        SERVER_ONLY(if (ent.pending_delete) continue;) \
-        if (ent.has_component(k##name)) cb(this, ent); \
-    } \
-}
-PERCOMPONENT
-#undef COMPONENT
\ No newline at end of file
+void Simulation::tick() {
+    rebuild_entity_lists();
+    on_tick();
+}
\ No newline at end of file
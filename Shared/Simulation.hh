@@ -5,25 +5,62 @@
 
 #ifdef SERVERSIDE
 #include <Server/SpatialHash.hh>
+#include <Server/TargetIndex.hh>
 #endif
 
-#include <functional>
 #include <string>
 
-inline uint32_t const ENTITY_CAP = 8192;
+#ifdef SERVERSIDE
+//physics-hot fields, one array per field indexed by Entity::slot (the same
+//as EntityID::id), so passes that walk the whole world can read them
+//without pulling in the rest of Entity. slot ENTITY_CAP is the overflow
+//entity's, see alloc_ent
+struct PhysicsFields {
+#undef HOT
+#define HOT(component, name, type, wire) std::array<type, ENTITY_CAP + 1> name;
+#define SINGLE(component, name, type, wire)
+#define MULTIPLE(component, name, type, amt, wire)
+    PERFIELD
+#undef SINGLE
+#undef MULTIPLE
+#undef HOT
+#define HOT(component, name, type, wire) SINGLE(component, name, type, wire)
+#define SINGLE(name, type, reset) std::array<type, ENTITY_CAP + 1> name;
+    PER_HOT_EXTRA_FIELD
+#undef SINGLE
+};
+#endif
 
 class Simulation {
-    std::array<uint8_t, div_round_up(ENTITY_CAP, 8)> entity_tracker;
+    std::array<uint64_t, div_round_up(ENTITY_CAP, 64)> entity_tracker;
     std::array<EntityID::hash_type, ENTITY_CAP> hash_tracker;
-    std::array<Entity, ENTITY_CAP> entities;
+    //every tracker word before this one is full, alloc_ent starts scanning here
+    uint32_t first_free_word;
+    uint32_t entity_count;
+    //slots are constructed in place the first time they are allocated
+    //(server entities need their physics slot), so a large ENTITY_CAP only
+    //reserves address space until the world actually grows that big
+    //entities[ENTITY_CAP] is the overflow entity, it is never tracked
+    Entity *entities;
+    uint32_t constructed_count;
+    void _construct_slots(uint32_t);
     StaticArray<EntityID::id_type, ENTITY_CAP> active_entities;
+    //active entities that have each component, rebuilt together with active_entities
+    std::array<StaticArray<EntityID::id_type, ENTITY_CAP>, kComponentCount> component_entities;
 public:
+    //the server runs one simulation, so entities find their slot without
+    //a pointer back to it. inline so it is set up before Server::game
+    SERVER_ONLY(static inline PhysicsFields physics;)
     SERVER_ONLY(std::array<uint32_t, PetalID::kNumPetals> petal_count_tracker;)
     SERVER_ONLY(std::array<uint32_t, MAP_DATA.size()> zone_mob_counts;)
     SERVER_ONLY(SpatialHash spatial_hash;)
+    //rebuilt right before the AI pass, see find_nearest_enemy
+    SERVER_ONLY(TargetIndex targets;)
     Arena arena_info;
     Simulation();
     void reset();
+    //when the cap is reached this returns a scratch entity whose id is
+    //NULL_ENTITY, spawn sites check for that before counting it anywhere
     Entity &alloc_ent();
     void _delete_ent(EntityID const &); //DANGEROUS
     void force_alloc_ent(EntityID const &);
@@ -31,12 +68,61 @@ public:
     Entity &get_ent(EntityID const &);
     uint8_t ent_exists(EntityID const &) const;
     uint8_t ent_alive(EntityID const &) const;
+    //hash of the entity in slot <id>, or of the next one if it is free
+    EntityID::hash_type hash_of(EntityID::id_type id) const { return hash_tracker[id]; }
+    uint32_t free_ent_count() const;
+    //refills active_entities and the component lists from the tracker
+    void rebuild_entity_lists();
     void tick();
     void on_tick();
     void post_tick();
 
     //will only consider active entities from the start of the tick() call
-    void for_each_entity(std::function<void (Simulation *, Entity &)>);
-    template <uint8_t>
-    void for_each(std::function<void (Simulation *, Entity &)>);
-};
\ No newline at end of file
+    //callbacks are taken as templates so that they can be inlined
+    //into the loop, they are called as cb(Simulation *, Entity &)
+    template<typename F>
+    void for_each_entity(F &&cb) {
+        for (uint32_t i = 0; i < active_entities.size(); ++i) {
+            if (!BitMath::at_arr(entity_tracker.data(), active_entities[i])) continue;
+            cb(this, entities[active_entities[i]]);
+        }
+    }
+
+    //only walks the entities that had <component> at the start of the tick
+    //outside tick() the lists can be a tick old and miss anything spawned
+    //since, callers there should rebuild_entity_lists() first
+    template<uint8_t component, typename F>
+    void for_each(F &&cb) {
+        StaticArray<EntityID::id_type, ENTITY_CAP> const &list = component_entities[component];
+        for (uint32_t i = 0; i < list.size(); ++i) {
+            if (!BitMath::at_arr(entity_tracker.data(), list[i])) continue;
+            Entity &ent = entities[list[i]];
+            SERVER_ONLY(if (ent.pending_delete) continue;)
+            if (ent.has_component(component)) cb(this, ent);
+        }
+    }
+};
+
+#ifdef SERVERSIDE
+#define SINGLE(name, type, reset) \
+inline type &Entity::name() { return Simulation::physics.name[slot]; } \
+inline type const &Entity::name() const { return Simulation::physics.name[slot]; }
+PER_HOT_EXTRA_FIELD
+#undef SINGLE
+#endif
+
+inline Entity &Simulation::get_ent(EntityID const &id) {
+    DEBUG_ONLY(assert(ent_exists(id));)
+    return entities[id.id];
+}
+
+#ifdef SERVERSIDE
+//the spatial hash iterators need a complete Simulation
+#ifdef GENERAL_SPATIAL_HASH
+#include <Server/SpatialHashCanonical.hh>
+#elif defined(SORTED_SPATIAL_HASH)
+#include <Server/SpatialHashSorted.hh>
+#else
+#include <Server/SpatialHashUniform.hh>
+#endif
+#endif